@@ -63,6 +63,21 @@ Gyro gyro;
   PandoHappy PandoSuperHappy  PandoSad   PandoSleeping  PandoFart  PandoConfused PandoLove  PandoAngry
   PandoFretful PandoMagic  PandoWave  PandoVictory  PandoFail*/
 
+//-- A gesture of our own (see Pando_timeline.h): a nod while beeping
+const uint8_t nod_code[] PROGMEM = {
+  G_EYES(happyOpen),
+  G_LOOP(3),
+    G_POSE(POSE_HEAD_LEFT, 200),
+    G_TONE(note_E6, 50, 0),
+    G_SYNC(SYNC_SERVOS),
+    G_POSE(POSE_HEAD_RIGHT, 200),
+    G_TONE(note_A6, 50, 0),
+    G_SYNC(SYNC_SERVOS),
+  G_NEXT,
+  G_HOME,
+  G_END
+};
+
 ///////////////////////////////////////////////////////////////////
 //-- Setup ------------------------------------------------------//
 ///////////////////////////////////////////////////////////////////
@@ -118,6 +133,9 @@ void loop() {
   
    Pando.playGesture(PandoThinking);
    delay(1000);
+
+   Pando.playProgram(nod_code);
+   delay(1000);
 }
 
 
@@ -0,0 +1,52 @@
+#include <Servo.h>
+#include <Pando.h>
+#include <Pando_link.h>
+#include "Gyro.h"
+#include <Wire.h>
+
+Pando Pando;  // This is Pando!
+PandoLink pandoLink;
+
+//---------------------------------------------------------
+//-- Gestures uploaded from the computer, without reflashing:
+//--   python tools/pando_link.py --port /dev/ttyUSB0 play my_gesture.txt
+//--   python tools/pando_link.py --port /dev/ttyUSB0 store 0 my_gesture.txt
+//-- (see tools/pando_link.py for the gesture text format)
+//---------------------------------------------------------
+#define PIN_YL 2 //servo[2]
+#define PIN_YR 3 //servo[3]
+#define PIN_RL 8 //servo[4]
+#define PIN_RR 9 //servo[5]
+
+#define NoiseSensor_PIN A1
+
+Gyro gyro;
+
+///////////////////////////////////////////////////////////////////
+//-- Setup ------------------------------------------------------//
+///////////////////////////////////////////////////////////////////
+void setup() {
+
+  Serial.begin(115200);
+
+  gyro.begin();
+
+  Pando.init(PIN_YL, PIN_YR, PIN_RL, PIN_RR, true, NoiseSensor_PIN);
+  Pando.attachGyro(gyro);
+  pandoLink.begin(Serial, Pando);
+
+  Pando.sing(S_connection); // Pando wake up!
+  Pando.home();
+}
+
+
+
+///////////////////////////////////////////////////////////////////
+//-- Principal Loop ---------------------------------------------//
+///////////////////////////////////////////////////////////////////
+void loop() {
+
+  // nothing may block here, or the frames get lost
+  pandoLink.update();
+  Pando.update();
+}
@@ -1,5 +1,6 @@
 #include <Servo.h>
 #include <Pando.h>
+#include <Pando_behavior.h>
 #include "Gyro.h"
 // #include "DFRobot_HT1632C.h"
 #include <Wire.h>
@@ -27,10 +28,13 @@ byte dato;  // To store the char sent by the app
 
 #define TOUCH_PIN A0
 #define NoiseSensor_PIN A1
-int touchVal = 0;
-int noiseVal = 0;
 
 Gyro gyro;
+Behavior behavior;  // Pando's mood: picks the gestures from the sensors
+
+// Uncomment to print the sensor samples, to tune the behavior on the computer
+// with tools/behavior_replay.cpp
+// #define RECORD_TRACE
 
 //GoBLE Goble(Serial);// init the bluetooth Serial port
 // Bluno default port - Serial
@@ -63,6 +67,37 @@ Gyro gyro;
   PandoHappy PandoSuperHappy  PandoSad   PandoSleeping  PandoFart  PandoConfused PandoLove  PandoAngry
   PandoFretful PandoMagic  PandoWave  PandoVictory  PandoFail*/
 
+///////////////////////////////////////////////////////////////////
+//-- Sensors ----------------------------------------------------//
+///////////////////////////////////////////////////////////////////
+// Runs at every tick of Pando, even in the middle of a gesture or a walk.
+// The sensors are only read once per behavior period, to keep the ticks short
+// (a single noise reading: getNoise() waits 8 ms)
+void sensors() {
+
+  static unsigned long last = 0;
+  if (millis() - last < BEHAVIOR_PERIOD) return;
+  last = millis();
+
+  SensorSample sample;
+  sample.touch = digitalRead(TOUCH_PIN) == HIGH;
+  sample.noise = analogRead(NoiseSensor_PIN);
+  sample.pitch = gyro.getAngleX();
+  sample.roll = gyro.getAngleY();
+
+#ifdef RECORD_TRACE
+  Serial.print(last); Serial.print(',');
+  Serial.print(sample.touch); Serial.print(',');
+  Serial.print(sample.noise); Serial.print(',');
+  Serial.print(sample.pitch); Serial.print(',');
+  Serial.println(sample.roll);
+#endif
+
+  // A gesture with a higher priority than the running one cuts it short
+  int8_t gesture = behavior.update(sample, last, Pando.getPriority());
+  if (gesture >= 0) Pando.requestGesture(gesture, behavior.getPriority());
+}
+
 ///////////////////////////////////////////////////////////////////
 //-- Setup ------------------------------------------------------//
 ///////////////////////////////////////////////////////////////////
@@ -77,6 +112,8 @@ void setup() {
   // Set the servo pins
   //  Pando.init(PIN_YL, PIN_YR, PIN_RL, PIN_RR, true);
   Pando.init(PIN_YL, PIN_YR, PIN_RL, PIN_RR, true, NoiseSensor_PIN);
+  Pando.attachGyro(gyro); // keep the gyro updated while Pando moves
+  Pando.attachTickHook(sensors); // and the sensors watched
 
   Pando.sing(S_connection); // Pando wake up!
   Pando.home();
@@ -90,45 +127,10 @@ void setup() {
 ///////////////////////////////////////////////////////////////////
 void loop() {
 
-  // update gyro
-  gyro.update();
-  Serial.read();
-  //   Serial.print("X:");
-  //   Serial.print(gyro.getAngleX());
-  //   Serial.print(" Y:");
-  //   Serial.print(gyro.getAngleY());
-  //   Serial.print(" Z:");
-  //   Serial.println(gyro.getAngleZ());
-  delay(10);
-
-  if ((abs(gyro.getAngleX()) > 50 && abs(gyro.getAngleX() < 80)) || (abs(gyro.getAngleY()) > 50 && abs(gyro.getAngleY() < 80)))
-  {
-    Pando.playGesture(PandoSad);
-  }
-
-  //   if(((gyro.getAngleX() > -10) && (gyro.getAngleX() < -3)) && ((gyro.getAngleY() > -10) && (gyro.getAngleY() < -3)))
-  //   {
-  //    Pando.playGesture(PandoAngry);
-  //   }
+  // plays the requests of sensors() and keeps the gyro updated
+  Pando.update();
 
   // testAllSongs();
-
-  // test touch sensor
-  touchVal = digitalRead(TOUCH_PIN);
-  if (touchVal == HIGH) {
-    Pando.playGesture(PandoLove);
-    delay(10);
-    touchVal = !touchVal;
-  }
-
-  // test noise sensor
-  noiseVal = Pando.getNoise();
-  delay(50);
-  Serial.println(noiseVal);
-  if (noiseVal > 30) {
-    Pando.playGesture(PandoSuperHappy);
-    noiseVal = 0;
-  }
 }
 
 
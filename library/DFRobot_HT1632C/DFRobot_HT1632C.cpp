@@ -14,6 +14,9 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#if defined(__AVR__)
+ #include <util/atomic.h>
+#endif
 /*
 const byte FONT_5X4 [] PROGMEM = {
     0b00000000,  //  
@@ -172,35 +175,54 @@ int FONT_8X4_END [] = {
 };
 
 DFRobot_HT1632C::DFRobot_HT1632C(uint8_t data, uint8_t wr, uint8_t RD, uint8_t cs){
-	data_t = data;
 	cs_t = cs;
-	wr_t = wr;
 	rd_t = rd_t;
-	
-	for(uint8_t i=0; i < 24; i++){
-		matrix[i] = 0;
-	}
-	matrix[0] = 0x40;
+	init(data, wr, &cs_t, 1, 1, panel);
 }
 
 DFRobot_HT1632C::DFRobot_HT1632C(uint8_t data, uint8_t wr, uint8_t cs){
-	data_t = data;
 	cs_t = cs;
+	init(data, wr, &cs_t, 1, 1, panel);
+}
+
+DFRobot_HT1632C::DFRobot_HT1632C(uint8_t data, uint8_t wr, const uint8_t *cs, uint8_t columns, uint8_t rows, uint8_t *memory){
+	cs_t = cs[0];
+	init(data, wr, cs, columns, rows, memory);
+}
+
+void DFRobot_HT1632C::init(uint8_t data, uint8_t wr, const uint8_t *cs, uint8_t columns, uint8_t rows, uint8_t *memory){
+	data_t = data;
 	wr_t = wr;
+	cs_pins = cs;
+	panelColumns = columns;
+	panelRows = rows;
+	panels = columns * rows;
+	width = columns * WIDTHSIZE;
+	height = rows * HEIGHTSIZE;
+	frameSize = panels * WIDTHSIZE;
 	
-	for(uint8_t i=0; i < 24; i++){
-		matrix[i] = 0;
-	}
+	matrix = memory;
+	front = memory + frameSize;
+	shadow = memory + 2 * frameSize;
+	memset(matrix, 0, frameSize);
 	matrix[0] = 0x40;
+	memcpy(front, matrix, frameSize);
+	shadowValid = false;
+	clearStats();
+	xIndex = 0;
+	scrollText = NULL;
 }
 
 void DFRobot_HT1632C::begin(){
-	pinMode(cs_t, OUTPUT); 
+	for(uint8_t chip=0; chip<panels; chip++){
+		pinMode(cs_pins[chip], OUTPUT);
+		digitalWrite(cs_pins[chip], HIGH);
+	}
   pinMode(wr_t, OUTPUT); 
   pinMode(data_t, OUTPUT);
 	
-	digitalWrite(cs_t, HIGH);
 	digitalWrite(wr_t, HIGH);
+	shadowValid = false;
 	
 	writeCommand(DFROBOT_HT1632_SYS_EN);
   writeCommand(DFROBOT_HT1632_LED_ON);
@@ -210,14 +232,13 @@ void DFRobot_HT1632C::begin(){
   writeCommand(DFROBOT_HT1632_COMMON_16NMOS);
   writeCommand(DFROBOT_HT1632_PWM_CONTROL | 0xF);
 	
-	width = 24;
-	height = 8;
 	xCoordinate = 0;
 	yCoordinate = 0;
 	fontValue = FONT8X4;
 }
 
 
+// Commands go to every chip
 void DFRobot_HT1632C::writeCommand(uint8_t cmd){
 	uint16_t str = 0;
 	str = DFROBOT_HT1632_COMMAND;
@@ -225,9 +246,20 @@ void DFRobot_HT1632C::writeCommand(uint8_t cmd){
 	str |= cmd;
 	str <<= 1;
 	
-	digitalWrite(cs_t, LOW);
-	writeBits(str, 12);
-	digitalWrite(cs_t, HIGH);
+	for(uint8_t chip=0; chip<panels; chip++){
+		select(chip);
+		writeBits(str, 12);
+		deselect(chip);
+	}
+}
+
+// A write transaction: chip select low, bits, chip select high
+void DFRobot_HT1632C::select(uint8_t chip){
+	digitalWrite(cs_pins[chip], LOW);
+}
+
+void DFRobot_HT1632C::deselect(uint8_t chip){
+	digitalWrite(cs_pins[chip], HIGH);
 }
 
 void DFRobot_HT1632C::writeBits(uint16_t data, uint8_t length){
@@ -246,44 +278,205 @@ void DFRobot_HT1632C::writeBits(uint16_t data, uint8_t length){
 	pinMode(data_t, INPUT);
 }
 
-void DFRobot_HT1632C::writeRAM(uint8_t addr, uint8_t data){
+void DFRobot_HT1632C::writeRAM(uint8_t chip, uint8_t addr, uint8_t data){
 	uint16_t str = DFROBOT_HT1632_WRITE;
 	str <<= 7;
 	str |= addr &0x7f;
 	str <<= 4;
 	str |= data & 0xf;
 	
-	digitalWrite(cs_t, LOW);
+	select(chip);
 	writeBits(str, 14);
-	digitalWrite(cs_t, HIGH);
+	deselect(chip);
+}
+
+
+// Make what was drawn the frame to send. The refresh only reads the
+// front buffer, and the swap is a single step for the interrupts, so a
+// refresh from an interrupt never sends a half drawn frame. Drawing goes
+// on from a copy of the frame
+void DFRobot_HT1632C::present(){
+	uint8_t *drawn = matrix;
+#if defined(__AVR__)
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#endif
+	{
+		matrix = front;
+		front = drawn;
+	}
+	memcpy(matrix, drawn, frameSize);
 }
 
-
 void DFRobot_HT1632C::writeScreen(){
-	digitalWrite(cs_t, LOW);
-	writeBits(DFROBOT_HT1632_WRITE,3);	
-	writeBits(0, 7);									
-	for(uint8_t i=0; i<24; i++){	
-		uint16_t str = matrix[i];		
-		str <<= 8;  
+	present();
+	refresh(false);
+}
+
+// Send the changes since the last write (see refresh)
+uint16_t DFRobot_HT1632C::flush(){
+	present();
+	return refresh(true);
+}
+
+// Send only some columns of the frame, to every chip they cross
+void DFRobot_HT1632C::writeColumns(uint8_t first, uint8_t count){
+	if(first >= width) return;
+	if(count > width - first) count = width - first;
+
+	present();
+	const uint8_t *frame = front;
+	uint16_t bits = 0;
+	for(uint8_t chip=0; chip<panels; chip++){
+		uint8_t left = (chip % panelColumns) * WIDTHSIZE;
+		uint8_t from = first > left ? first - left : 0;
+		uint8_t to = first + count < left + WIDTHSIZE ? first + count - left : WIDTHSIZE;
+		if(first + count > left && from < WIDTHSIZE) bits += writeChip(frame, chip, from, to - from);
+	}
+	sent(bits);
+}
+
+// Send the presented frame, whole or only the nibbles that differ from
+// the chip RAM, chip by chip. It does not touch the drawing, so a timer
+// interrupt can call it while the sketch draws the next frame. Returns
+// the bits sent
+uint16_t DFRobot_HT1632C::refresh(boolean partial){
+	return send(front, partial);
+}
+
+// Send a frame of the sketch instead of the drawing, laid out as
+// getBuffer(), with the changes only (see DFRobot_HT1632C_Gray)
+uint16_t DFRobot_HT1632C::show(const uint8_t *frame){
+	return send(frame, true);
+}
+
+uint16_t DFRobot_HT1632C::send(const uint8_t *frame, boolean partial){
+	uint16_t bits = 0;
+	
+	for(uint8_t chip=0; chip<panels; chip++){
+		if(!partial || !shadowValid) bits += writeChip(frame, chip, 0, WIDTHSIZE);
+		else bits += refreshChip(frame, chip);
+	}
+	shadowValid = true;
+	
+	sent(bits);
+	return bits;
+}
+
+// Where the first column of a chip is in a frame. The next ones are
+// panelRows bytes apart
+uint16_t DFRobot_HT1632C::chipOffset(uint8_t chip){
+	return (chip % panelColumns) * WIDTHSIZE * panelRows + chip / panelColumns;
+}
+
+// Columns of a chip (successive address mode): a column holds 4 nibbles
+// of chip RAM, so it starts at address 4 * column. Returns the bits sent
+uint16_t DFRobot_HT1632C::writeChip(const uint8_t *frame, uint8_t chip, uint8_t first, uint8_t count){
+	uint16_t offset = chipOffset(chip) + first * panelRows;
+	
+	select(chip);
+	writeBits(DFROBOT_HT1632_WRITE,3);
+	writeBits(first << 2, 7);
+	for(uint8_t i=0; i<count; i++, offset += panelRows){
+		uint16_t str = frame[offset];
+		str <<= 8;
 		writeBits(str, 16);
+		shadow[offset] = frame[offset];
+	}
+	deselect(chip);
+	
+	return 3 + 7 + count * 16;
+}
+
+// The nibbles of a chip that differ from its RAM. A write costs 10 bits
+// of command and address, then 4 bits per nibble, so changes up to 2
+// nibbles apart go in one successive address write: a pupil that moves
+// is a few short writes instead of 394 bits
+uint16_t DFRobot_HT1632C::refreshChip(const uint8_t *frame, uint8_t chip){
+	uint16_t offset = chipOffset(chip);
+	uint16_t bits = 0;
+	int8_t first = -1, last = -1;
+	
+	for(uint8_t i=0; i<24; i++, offset += panelRows){
+		uint8_t diff = frame[offset] ^ shadow[offset];
+		if(!diff) continue;
+		
+		// Rows 0-3 are the nibble at 4 * column, rows 4-7 the next one
+		int8_t from = (i << 2) + ((diff & 0xF0) ? 0 : 1);
+		if(first >= 0 && from - last > 3){
+			bits += writeNibbles(frame, chip, first, last);
+			first = -1;
+		}
+		if(first < 0) first = from;
+		last = (i << 2) + ((diff & 0x0F) ? 1 : 0);
+	}
+	if(first >= 0) bits += writeNibbles(frame, chip, first, last);
+	
+	return bits;
+}
+
+// Nibble of chip RAM at an address: a column has 16 rows of RAM, the
+// last 8 are not wired
+uint8_t DFRobot_HT1632C::nibble(const uint8_t *frame, uint16_t offset, uint8_t addr){
+	uint8_t column = frame[offset + (addr >> 2) * panelRows];
+	switch(addr & 3){
+		case 0: return column >> 4;
+		case 1: return column & 0xF;
+		default: return 0;
 	}
-	digitalWrite(cs_t, HIGH);
+}
+
+// Write the nibbles of a chip from first to last, returns the bits sent
+uint16_t DFRobot_HT1632C::writeNibbles(const uint8_t *frame, uint8_t chip, uint8_t first, uint8_t last){
+	uint16_t offset = chipOffset(chip);
+	
+	if(first == last){
+		writeRAM(chip, first, nibble(frame, offset, first));
+	}else{
+		select(chip);
+		writeBits(DFROBOT_HT1632_WRITE,3);
+		writeBits(first, 7);
+		for(uint8_t addr=first; addr<=last; addr++){
+			writeBits(nibble(frame, offset, addr), 4);
+		}
+		deselect(chip);
+	}
+	
+	// The nibbles of these columns that were not sent were already equal
+	for(uint8_t i=first >> 2; i<=(last >> 2); i++){
+		shadow[offset + i * panelRows] = frame[offset + i * panelRows];
+	}
+	return 3 + 7 + 4 * (last - first + 1);
+}
+
+void DFRobot_HT1632C::sent(uint16_t bits){
+	stats.frames++;
+	stats.bits += bits;
+	stats.frameBits = bits;
+}
+
+void DFRobot_HT1632C::clearStats(){
+	stats.frames = 0;
+	stats.bits = 0;
+	stats.frameBits = 0;
+}
+
+// Show a whole screen in PROGMEM, laid out as getBuffer()
+void DFRobot_HT1632C::drawFrame(const uint8_t *frame){
+	memcpy_P(matrix, frame, frameSize);
+	this->writeScreen();
 }
 
 void DFRobot_HT1632C::fillScreen(){
-	for (uint8_t i=0; i<24; i++) {
+	for (uint16_t i=0; i<frameSize; i++) {
     matrix[i] = 0xFF;
   }
   this->writeScreen();
 }
 
 void DFRobot_HT1632C::clearScreen() {
-  for (uint8_t i=0; i<24; i++) {
+  for (uint16_t i=0; i<frameSize; i++) {
     matrix[i] = 0;
   }
-	free(matrices);
-	matrices = NULL;
   this->writeScreen();
 }
 
@@ -342,13 +535,13 @@ void DFRobot_HT1632C::clrPixel(uint16_t i){
 void DFRobot_HT1632C::setPixel(uint8_t x, uint8_t y){
 	if((x<0) || (x>=width) || (y<0) || (y>=height))	return;
 	
-	matrix[x] |= 0x80>>y;
+	matrix[pixelOffset(x, y)] |= 0x80>>(y & 7);
 }
 
 void DFRobot_HT1632C::clrPixel(uint8_t x, uint8_t y){
 	if((x<0) || (x>=width) || (y<0) || (y>=height))	return;
 	
-	matrix[x] &= ~(0x80>>y);
+	matrix[pixelOffset(x, y)] &= ~(0x80>>(y & 7));
 }
 
 void DFRobot_HT1632C::setPwm(uint8_t value){
@@ -434,12 +627,12 @@ void DFRobot_HT1632C::clrLine(uint8_t xStart, uint8_t yStart, uint8_t xStop, uin
   }
 }
 
-void DFRobot_HT1632C::drawImage(const byte * img, uint8_t width_t, uint8_t height_t, int8_t x, int8_t y, int img_offset){
+void DFRobot_HT1632C::drawImage(const byte * img, uint8_t width_t, uint8_t height_t, int16_t x, int16_t y, int img_offset){
 	uint8_t bytesPerColumn = (height_t >> 3) + ((height_t & 0b111)?1:0);
 	if(y + height_t < 0 || x + width_t < 0 || y > height || x > width){
 		return;
 	}
-	uint8_t dst_x = x;
+	int16_t dst_x = x;
 	uint8_t src_x = 0;
 	while(src_x < width_t){
 		if(dst_x < 0){
@@ -450,7 +643,7 @@ void DFRobot_HT1632C::drawImage(const byte * img, uint8_t width_t, uint8_t heigh
 			break;
 		}
 		uint8_t src_y = 0;
-		uint8_t dst_y = y;
+		int16_t dst_y = y;
 		while(src_y < height_t){
 			if(dst_y < 0){
 				src_y -= dst_y;
@@ -461,54 +654,13 @@ void DFRobot_HT1632C::drawImage(const byte * img, uint8_t width_t, uint8_t heigh
 			}
 			
 			uint8_t copyInNextStep = 8 - max((src_y & 0b111), (dst_y & 0b111));
-			copyInNextStep = min(copyInNextStep, (height - src_y));
+			copyInNextStep = min(copyInNextStep, (height_t - src_y));
 			uint8_t dst_copyMask = (0b1 << copyInNextStep) - 1;
 			dst_copyMask <<= (8 - (dst_y & 0b111) - copyInNextStep);
 			uint8_t copyData = pgm_read_byte(&img[img_offset + (bytesPerColumn * src_x) + (src_y >> 3)]) << (src_y & 0b111);
 			copyData >>= (dst_y & 0b111);
-			matrix[GET_ADDR_FROM_X_Y(dst_x, dst_y)] =  (matrix[GET_ADDR_FROM_X_Y(dst_x, dst_y)] & ~dst_copyMask) | (copyData & dst_copyMask); 
-
-			src_y += copyInNextStep;
-			dst_y += copyInNextStep;
-		}
-		src_x++;
-		dst_x++;
-	}
-}
-
-void DFRobot_HT1632C::drawImageStr(const byte * img, uint8_t width_t, uint8_t height_t, int8_t x, int8_t y, int img_offset){
-	uint8_t bytesPerColumn = (height_t >> 3) + ((height_t & 0b111)?1:0);
-	if(y + height_t < 0 || x + width_t < 0 || y > height || x > width){
-		return;
-	}
-	uint8_t dst_x = x;
-	uint8_t src_x = 0;
-	while(src_x < width_t){
-		if(dst_x < 0){
-			src_x++;
-			dst_x++;
-			continue;
-		}else if(dst_x >= width){
-			break;
-		}
-		uint8_t src_y = 0;
-		uint8_t dst_y = y;
-		while(src_y < height_t){
-			if(dst_y < 0){
-				src_y -= dst_y;
-				dst_y = 0;
-				continue;
-			}else if(dst_y >= height){
-				break;
-			}
-			
-			uint8_t copyInNextStep = 8 - max((src_y & 0b111), (dst_y & 0b111));
-			copyInNextStep = min(copyInNextStep, (height - src_y));
-			uint8_t dst_copyMask = (0b1 << copyInNextStep) - 1;
-			dst_copyMask <<= (8 - (dst_y & 0b111) - copyInNextStep);
-			uint8_t copyData = pgm_read_byte(&img[img_offset + (bytesPerColumn * src_x) + (src_y >> 3)]) << (src_y & 0b111);
-			copyData >>= (dst_y & 0b111);
-			matrices[GET_ADDR_FROM_X_Y(dst_x, dst_y)] =  (matrices[GET_ADDR_FROM_X_Y(dst_x, dst_y)] & ~dst_copyMask) | (copyData & dst_copyMask); 
+			uint8_t *dst = &matrix[pixelOffset(dst_x, dst_y)];
+			*dst = (*dst & ~dst_copyMask) | (copyData & dst_copyMask);
 
 			src_y += copyInNextStep;
 			dst_y += copyInNextStep;
@@ -523,7 +675,7 @@ void DFRobot_HT1632C::drawText(const char text [], int x, int y, const byte font
 	unsigned int i = 0;
 	char currchar;
 	
-	if(y + font_height < 0 || y >= HEIGHTSIZE){
+	if(y + font_height < 0 || y >= height){
 		return;
 	}
 	
@@ -540,7 +692,7 @@ void DFRobot_HT1632C::drawText(const char text [], int x, int y, const byte font
 			continue; 
 		}
 
-		if(curr_x >= WIDTHSIZE){
+		if(curr_x >= width){
 			break; 
 		}
 		
@@ -556,43 +708,6 @@ void DFRobot_HT1632C::drawText(const char text [], int x, int y, const byte font
 	}
 }
 
-void DFRobot_HT1632C::drawTextStr(const char text [], int x, int y, const byte font [], int font_end [], uint8_t font_height, uint8_t gutter_space){
-	int curr_x = x;
-	uint8_t i = 0;
-	char currchar;
-	
-	if(y + font_height < 0 || y >= HEIGHTSIZE){
-		return;
-	}
-	
-	while(true){  
-		if(text[i] == '\0')
-			return;
-		
-		currchar = text[i] - 32;
-		if(currchar >= 65 && currchar <= 90) 
-			currchar -= 32; 
-
-		if(currchar < 0 || currchar >= 64) { 
-			++i;
-			continue; 
-		}
-
-		if(curr_x >= WIDTHSIZE){
-			//break; 
-		}
-		int chr_width = getCharWidth(font_end, font_height, currchar);
-		if(curr_x + chr_width + gutter_space >= 0){
-			drawImageStr(font, chr_width, font_height, curr_x, y,  getCharOffset(font_end, currchar));
-			for(char j = 0; j < gutter_space; ++j)
-			drawImageStr(font, 1, font_height, curr_x + chr_width + j, y, 0);
-		}
-		
-		curr_x += chr_width + gutter_space;
-		++i;
-	}
-}
-
 int DFRobot_HT1632C::getCharWidth(int font_end [], uint8_t font_height, uint8_t font_index) {
 	uint8_t bytesPerColumn = (font_height >> 3) + ((font_height & 0b111)?1:0); 
 
@@ -613,7 +728,7 @@ int DFRobot_HT1632C::getCharOffset(int font_end [], uint8_t font_index) {
 
 int DFRobot_HT1632C::getTextWidth(const char text [], int font_end [], uint8_t font_height, uint8_t gutter_space) {
 	int wd = 0;
-	uint8_t i = 0;
+	unsigned int i = 0;
 	char currchar;
 	
 	while(true){  
@@ -756,105 +871,114 @@ void DFRobot_HT1632C::print(const char value[]){
 	this->writeScreen();
 }
 
-void DFRobot_HT1632C::printStr(const char str[], uint8_t value){
-	if(fontValue == FONT8X4)
-		this->drawTextStr(str, xCoordinate, yCoordinate, FONT_8X4, FONT_8X4_END, FONT_8X4_HEIGHT);
+void DFRobot_HT1632C::print(const char str[], uint16_t speed){
+	this->setCursorIndex(0, 0);
+	this->scroll(str, speed);
+	while(this->updateScroll());
 }
 
-void DFRobot_HT1632C::print(const char str[], uint16_t speed){
-	this->length = strlen(str)*5;
-	this->doLength(str);
-	
-	this->width = length;
-	matrices = (char*)malloc(length+24);	
-	if(matrices == NULL)	return;
-	memset(matrices,'\0',length+24);
-
-	this->setCursorIndex(0,0);
-	this->printStr(str);	
-	for(uint8_t i=1; i<length+24;i++){	
-		for(uint8_t j = xIndex; j<24-xIndex; j++){
-			matrix[j] = '\0';
-		}
-		
-		if(i <= 24-xIndex){
-			memcpy(&matrix[24-i], &matrices[0], i);
-		}else{
-			memcpy(&matrix[xIndex], &matrices[i-24+xIndex], 24-xIndex);	
-		}
-		this->writeScreen();
-		delay(speed);
+void DFRobot_HT1632C::scroll(const char text[], uint16_t speed){
+	startScroll(text, false, speed);
+}
+
+void DFRobot_HT1632C::scroll(const __FlashStringHelper *text, uint16_t speed){
+	startScroll(reinterpret_cast<const char *>(text), true, speed);
+}
+
+void DFRobot_HT1632C::startScroll(const char *text, boolean flash, uint16_t speed){
+	scrollText = NULL;
+	if(xIndex >= width || yCoordinate >= height) return;
+
+	scrollFlash = flash;
+	scrollColumn = 0;
+	scrollLeft = xIndex;
+	scrollTop = yCoordinate;
+	scrollBlank = width - scrollLeft;
+	scrollSpeed = speed;
+	scrollTime = millis() - speed;  // The first column comes in at once
+	for(uint8_t x=scrollLeft; x<width; x++){
+		putColumn(x, 0);
 	}
-	free(matrices);
-  matrices = NULL; 
+	scrollText = text;
 }
 
-void DFRobot_HT1632C::doLength(const char text[]){
-	char currchar;
-	uint8_t i = 0;
-	
-	while(true){  
-		if (text[i] == '\0') {
+// Move the text on by the columns whose time has come. If the calls were
+// late, it jumps: at most a whole width at once, and then it keeps time
+// from now instead of catching up
+boolean DFRobot_HT1632C::updateScroll(){
+	if(scrollText == NULL) return false;
+
+	unsigned long elapsed = millis() - scrollTime;
+	if(elapsed < scrollSpeed) return true;
+
+	uint8_t steps = width - scrollLeft;
+	if(scrollSpeed == 0){
+		steps = 1;
+		scrollTime += elapsed;
+	}else if(elapsed / scrollSpeed < steps){
+		steps = elapsed / scrollSpeed;
+		scrollTime += (unsigned long)steps * scrollSpeed;
+	}else{
+		scrollTime += elapsed;
+	}
+
+	for(; steps > 0 && scrollText != NULL; steps--){
+		scrollStep();
+	}
+	this->flush();
+	return scrollText != NULL;
+}
+
+// Shift the area left and bring in the next column of the text: a column
+// of the character, the gap after it, or blank once the text has ended
+void DFRobot_HT1632C::scrollStep(){
+	uint8_t bits = 0;
+	while(true){
+		char c = scrollFlash ? pgm_read_byte(scrollText) : *scrollText;
+		if(c == '\0'){
+			scrollBlank--;
 			break;
 		}
-			
-		currchar = text[i] - 32;
-		if (currchar >= 65 && currchar <= 90) { 
-			currchar -= 32;                    
-		}
 
-		if (currchar < 0 || currchar >= 64) {   
-			++i;
-			continue; 
+		char currchar = c - 32;
+		if(currchar >= 65 && currchar <= 90)
+			currchar -= 32;
+		if(currchar < 0 || currchar >= 64){
+			scrollText++;
+			continue;
 		}
-		switch(currchar){
-			case 12:
-			case 27:
-			case 59:
-			case 61:
-				this->length -= 2;
-				break;
-			
-			case 0:
-			case 7:
-			case 14:
-			case 26:
-				this->length -= 3;
-				break;
-			
-			case 1:
-			case 2:
-			case 8:
-			case 9:
-			case 10:
-			case 13:
-			case 41:
-			case 52:
-			case 62:
-				this->length -= 1;
-				break;
-			
-			case 3:
-			case 4:
-			case 5:
-			case 11:
-			case 17:
-			case 32:
-			case 45:
-			case 46:
-			case 49:
-			case 55:
-			case 56:
-			case 57:
-				this->length += 1;
-				break;
+
+		uint8_t chr_width = getCharWidth(FONT_8X4_END, FONT_8X4_HEIGHT, currchar);
+		if(scrollColumn < chr_width){
+			bits = pgm_read_byte(&FONT_8X4[getCharOffset(FONT_8X4_END, currchar) + scrollColumn]);
+			scrollColumn++;
+		}else{
+			scrollText++;
+			scrollColumn = 0;
 		}
-		++i;
+		break;
 	}
-}
-
-
-
 
+	for(uint8_t x=scrollLeft; x<width-1; x++){
+		putColumn(x, getColumn(x + 1));
+	}
+	putColumn(width - 1, bits);
+	if(scrollBlank == 0) scrollText = NULL;
+}
 
+// The 8 rows of a column from scrollTop, bit 7 the top row. They span two
+// bytes of the frame when scrollTop is not a multiple of 8
+uint8_t DFRobot_HT1632C::getColumn(uint8_t x){
+	const uint8_t *column = &matrix[pixelOffset(x, scrollTop)];
+	uint8_t shift = scrollTop & 7;
+	uint8_t bits = column[0] << shift;
+	if(shift && (scrollTop >> 3) + 1 < panelRows) bits |= column[1] >> (8 - shift);
+	return bits;
+}
 
+void DFRobot_HT1632C::putColumn(uint8_t x, uint8_t bits){
+	uint8_t *column = &matrix[pixelOffset(x, scrollTop)];
+	uint8_t shift = scrollTop & 7;
+	column[0] = (column[0] & ~(0xFF >> shift)) | (bits >> shift);
+	if(shift && (scrollTop >> 3) + 1 < panelRows) column[1] = (column[1] & (0xFF >> shift)) | (uint8_t)(bits << (8 - shift));
+}
@@ -61,6 +61,17 @@
 #define HEIGHTSIZE 8
 #define PIXELS_PER_BYTE 8
 
+// Memory for panels chained as one display: the frame drawn, the frame
+// presented and what the chips hold
+#define HT1632C_MEMORY(panels) (3 * WIDTHSIZE * (panels))
+
+// What the driver sent to the display RAM (see getStats)
+struct HT1632C_Stats{
+	unsigned long frames;   // writeScreen() and flush() calls
+	unsigned long bits;     // Bits of RAM writes, commands aside
+	uint16_t frameBits;     // Bits of the last frame
+};
+
 #define _swap_int16_t(a, b) { int16_t t = a; a = b; b = t; }
 #define GET_ADDR_FROM_X_Y(_x,_y) ((_x)*((HEIGHTSIZE)/(PIXELS_PER_BYTE))+(_y)/(PIXELS_PER_BYTE))
 
@@ -68,6 +79,10 @@ class DFRobot_HT1632C{
 public:
 	DFRobot_HT1632C(uint8_t data, uint8_t wr, uint8_t RD, uint8_t cs);
 	DFRobot_HT1632C(uint8_t data, uint8_t wr, uint8_t cs);
+	// Panels side by side and rows of them, as one display. The chips
+	// share DATA and WR, cs[] has their CS pins row by row. memory is
+	// HT1632C_MEMORY(columns * rows) bytes
+	DFRobot_HT1632C(uint8_t data, uint8_t wr, const uint8_t *cs, uint8_t columns, uint8_t rows, uint8_t *memory);
 	
 	void begin(void);
 	void clrPixel(uint16_t i);
@@ -82,8 +97,23 @@ public:
 
   void clearScreen();
   void fillScreen();
+  // Drawing goes to a back buffer. present() makes it the frame refresh()
+  // sends, writeScreen() and flush() do both
   void writeScreen();
+  void writeColumns(uint8_t first, uint8_t count);
+  uint16_t flush();  // Send what changed since the last write, returns the bits sent
+  void present();
+  uint16_t refresh(boolean partial = true);  // Safe from an interrupt, if only it writes the display
+  uint16_t show(const uint8_t *frame);
+  void drawFrame(const uint8_t *frame);
+  // Column by column, getHeight() / 8 bytes a column, bit 7 the top row
+  // of a byte (24 bytes for one panel). Changes at every present()
+  uint8_t *getBuffer() {return matrix;}
+  uint8_t getWidth() {return width;}
+  uint8_t getHeight() {return height;}
   void dumpScreen();
+  const HT1632C_Stats &getStats() {return stats;}
+  void clearStats();
 	void inLowpower(boolean state);
 	
 	void drawLine(uint8_t xStart, uint8_t yStart, uint8_t xStop, uint8_t yStop);
@@ -92,7 +122,6 @@ public:
 	int getTextWidth(const char text [], int font_end [], uint8_t font_height, uint8_t gutter_space=1);
 	
 	void drawText(const char text [], int x, int y, const byte font [], int font_end [], uint8_t font_height, uint8_t gutter_space = 1);
-	void drawTextStr(const char text [], int x, int y, const byte font [], int font_end [], uint8_t font_height, uint8_t gutter_space = 1);
 	
 	void setCursor(uint8_t x, uint8_t y);
 	void setCursorIndex(uint8_t x, uint8_t y);
@@ -110,30 +139,332 @@ public:
 	void print(double, uint8_t = 2);
 	void print(float, uint8_t = 2);
 	
-	void print(const char str[], uint16_t speed);
-	void printStr(const char str[], uint8_t value=0);
+	// Text scrolling in from the right edge to the cursor, a column every
+	// speed ms, in the 8 rows under the cursor. The columns are read from
+	// the font as they come in, the text is not copied: it must stay as
+	// long as it scrolls. F("...") for a text in PROGMEM
+	void scroll(const char text[], uint16_t speed);
+	void scroll(const __FlashStringHelper *text, uint16_t speed);
+	boolean updateScroll();  // Call it often, false once the text has gone
+	void stopScroll() {scrollText = NULL;}
+	void print(const char str[], uint16_t speed);  // scroll() until the text has gone
+
+protected:
+	// The bus, overridden by DFRobot_HT1632C_Fast
+	virtual void select(uint8_t chip);
+	virtual void deselect(uint8_t chip);
+	virtual void writeBits(uint16_t data, uint8_t length);
+	uint8_t csPin(uint8_t chip) {return cs_pins[chip];}
 
 private:
-	char* strBuffer;
-	uint8_t length;
 	uint8_t xIndex;
   uint8_t width, height;
 	uint8_t xCoordinate, yCoordinate, fontValue;
 	uint8_t data_t, cs_t, wr_t, rd_t;
-	uint8_t matrix[24]; //24*8/8
-	char* matrices;
+	const uint8_t *cs_pins;
+	uint8_t panelColumns, panelRows, panels;
+	uint16_t frameSize; // Bytes of a frame
+	uint8_t panel[HT1632C_MEMORY(1)]; // The memory of a single panel
+	uint8_t *matrix; // Drawn into
+	uint8_t *volatile front; // Presented, what refresh() sends
+	uint8_t *shadow; // What the chip RAM holds
+	boolean shadowValid; // False until a whole screen was written
+	HT1632C_Stats stats;
+	const char *scrollText; // Next character, NULL when not scrolling
+	boolean scrollFlash;    // The text is in PROGMEM
+	uint8_t scrollColumn;   // Next column of the character, its width for the gap
+	uint8_t scrollLeft, scrollTop;
+	uint8_t scrollBlank;    // Blank columns after the text, until it has gone
+	uint16_t scrollSpeed;
+	unsigned long scrollTime;
+	void init(uint8_t data, uint8_t wr, const uint8_t *cs, uint8_t columns, uint8_t rows, uint8_t *memory);
+	uint16_t chipOffset(uint8_t chip);
+	uint16_t pixelOffset(uint8_t x, uint8_t y) {return (uint16_t)x * panelRows + (y >> 3);}
 	void writeCommand(uint8_t cmd);
-	void writeBits(uint16_t data, uint8_t length);
-	void writeRAM(uint8_t addr, uint8_t data);
+	void writeRAM(uint8_t chip, uint8_t addr, uint8_t data);
+	uint16_t send(const uint8_t *frame, boolean partial);
+	uint16_t writeChip(const uint8_t *frame, uint8_t chip, uint8_t first, uint8_t count);
+	uint16_t refreshChip(const uint8_t *frame, uint8_t chip);
+	uint8_t nibble(const uint8_t *frame, uint16_t offset, uint8_t addr);
+	uint16_t writeNibbles(const uint8_t *frame, uint8_t chip, uint8_t first, uint8_t last);
+	void sent(uint16_t bits);
 	
-	void doLength(const char text[]);
+	void startScroll(const char *text, boolean flash, uint16_t speed);
+	void scrollStep();
+	uint8_t getColumn(uint8_t x);
+	void putColumn(uint8_t x, uint8_t bits);
 	
-	void drawImage(const byte * img, uint8_t width_t, uint8_t height_t, int8_t x, int8_t y, int img_offset);
-	void drawImageStr(const byte * img, uint8_t width_t, uint8_t height_t, int8_t x, int8_t y, int img_offset);
+	void drawImage(const byte * img, uint8_t width_t, uint8_t height_t, int16_t x, int16_t y, int img_offset);
 	int getCharWidth(int font_end [], uint8_t font_height, uint8_t font_index);
 	int getCharOffset(int font_end [], uint8_t font_index);
 };
 
+// Pins known at compile time. On the ATmega328 family (Uno, Nano, Pro Mini)
+// the port of a pin is a constant, so every write is a single sbi or cbi
+// instruction instead of a digitalWrite() pin table lookup
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__)
+ #define HT1632C_PORT_PINS
+#endif
+
+template<uint8_t PIN> struct HT1632C_Pin {
+#ifdef HT1632C_PORT_PINS
+	static volatile uint8_t &port() {return PIN < 8 ? PORTD : (PIN < 14 ? PORTB : PORTC);}
+	static volatile uint8_t &ddr() {return PIN < 8 ? DDRD : (PIN < 14 ? DDRB : DDRC);}
+	static uint8_t mask() {return 1 << (PIN < 8 ? PIN : (PIN < 14 ? PIN - 8 : PIN - 14));}
+
+	static void high() {port() |= mask();}
+	static void low() {port() &= ~mask();}
+	static void output() {ddr() |= mask();}
+	static void input() {ddr() &= ~mask();}
+#else
+	static void high() {digitalWrite(PIN, HIGH);}
+	static void low() {digitalWrite(PIN, LOW);}
+	static void output() {pinMode(PIN, OUTPUT);}
+	static void input() {pinMode(PIN, INPUT);}
+#endif
+};
+
+// The same driver, with the pins given as template parameters: the data
+// pin is an output for a whole transaction, not around every writeBits()
+template<uint8_t DATA, uint8_t WR, uint8_t CS>
+class DFRobot_HT1632C_Fast : public DFRobot_HT1632C{
+public:
+	DFRobot_HT1632C_Fast() : DFRobot_HT1632C(DATA, WR, CS) {}
+	// Chained panels, CS is cs[0]. The other chips are selected with digitalWrite()
+	DFRobot_HT1632C_Fast(const uint8_t *cs, uint8_t columns, uint8_t rows, uint8_t *memory)
+		: DFRobot_HT1632C(DATA, WR, cs, columns, rows, memory) {}
+
+protected:
+	virtual void select(uint8_t chip){
+		HT1632C_Pin<DATA>::output();
+		if(chip == 0) HT1632C_Pin<CS>::low();
+		else digitalWrite(this->csPin(chip), LOW);
+	}
+
+	virtual void deselect(uint8_t chip){
+		if(chip == 0) HT1632C_Pin<CS>::high();
+		else digitalWrite(this->csPin(chip), HIGH);
+		HT1632C_Pin<DATA>::input();
+	}
+
+	// Most significant bit first, the chip reads it on the WR rising edge
+	virtual void writeBits(uint16_t data, uint8_t length){
+		data <<= 16 - length;
+		for(; length > 0; length--, data <<= 1){
+			HT1632C_Pin<WR>::low();
+			if(data & 0x8000) HT1632C_Pin<DATA>::high();
+			else HT1632C_Pin<DATA>::low();
+			HT1632C_Pin<WR>::high();
+		}
+	}
+};
+
+// Bytes through a hardware shift register. The chip takes 3 bits of
+// command and 7 of address before the data, so a transaction is rarely
+// whole bytes: what is left at the end is bit-banged on the same pins,
+// and the chip gets exactly the bits writeBits() would send
+template<uint8_t DATA, uint8_t WR, uint8_t CS>
+class DFRobot_HT1632C_Serial : public DFRobot_HT1632C_Fast<DATA, WR, CS>{
+public:
+	DFRobot_HT1632C_Serial() {}
+	DFRobot_HT1632C_Serial(const uint8_t *cs, uint8_t columns, uint8_t rows, uint8_t *memory)
+		: DFRobot_HT1632C_Fast<DATA, WR, CS>(cs, columns, rows, memory) {}
+
+protected:
+	virtual void select(uint8_t chip){
+		DFRobot_HT1632C_Fast<DATA, WR, CS>::select(chip);
+		pendingBits = 0;
+		start();
+	}
+
+	virtual void deselect(uint8_t chip){
+		stop();
+		if(pendingBits) DFRobot_HT1632C_Fast<DATA, WR, CS>::writeBits(pending, pendingBits);
+		DFRobot_HT1632C_Fast<DATA, WR, CS>::deselect(chip);
+	}
+
+	virtual void writeBits(uint16_t data, uint8_t length){
+		pending = (pending << length) | (data & ((1UL << length) - 1));
+		pendingBits += length;
+		while(pendingBits >= 8){
+			pendingBits -= 8;
+			shiftOut(pending >> pendingBits);
+		}
+	}
+
+	virtual void start() = 0;                // The shift register takes the pins
+	virtual void stop() = 0;                 // After the last byte, the port gets them back
+	virtual void shiftOut(uint8_t data) = 0; // Most significant bit first
+
+private:
+	uint32_t pending;
+	uint8_t pendingBits;
+};
+
+#ifdef HT1632C_PORT_PINS
+
+// WR clock of the shift registers. The chip reads DATA on the rising
+// edge of WR: SPI mode 3
+#ifndef HT1632C_SERIAL_CLOCK
+ #define HT1632C_SERIAL_CLOCK 2000000
+#endif
+
+// Hardware SPI: DATA on MOSI (11), WR on SCK (13). Pin 10 (SS) is made
+// an output, as an input could take the SPI out of master mode
+template<uint8_t CS>
+class DFRobot_HT1632C_SPI : public DFRobot_HT1632C_Serial<MOSI, SCK, CS>{
+public:
+	DFRobot_HT1632C_SPI() {}
+	DFRobot_HT1632C_SPI(const uint8_t *cs, uint8_t columns, uint8_t rows, uint8_t *memory)
+		: DFRobot_HT1632C_Serial<MOSI, SCK, CS>(cs, columns, rows, memory) {}
+
+protected:
+	virtual void start(){
+		// F_CPU divided by 2, 4, 8 or 16, the first that is not too fast
+		const unsigned long ratio = F_CPU / HT1632C_SERIAL_CLOCK;
+		HT1632C_Pin<SS>::output();
+		SPCR = _BV(SPE) | _BV(MSTR) | _BV(CPOL) | _BV(CPHA) | (ratio > 4 ? _BV(SPR0) : 0);
+		SPSR = ratio <= 2 || (ratio > 4 && ratio <= 8) ? _BV(SPI2X) : 0;
+	}
+
+	virtual void stop(){
+		SPCR = 0;
+	}
+
+	virtual void shiftOut(uint8_t data){
+		SPDR = data;
+		while(!(SPSR & _BV(SPIF)));
+	}
+};
+
+// USART0 in SPI master mode: DATA on TXD (1), WR on XCK (4). It sends
+// the next byte while one shifts out, but Serial can not be used
+template<uint8_t CS>
+class DFRobot_HT1632C_USART : public DFRobot_HT1632C_Serial<1, 4, CS>{
+public:
+	DFRobot_HT1632C_USART() {}
+	DFRobot_HT1632C_USART(const uint8_t *cs, uint8_t columns, uint8_t rows, uint8_t *memory)
+		: DFRobot_HT1632C_Serial<1, 4, CS>(cs, columns, rows, memory) {}
+
+protected:
+	virtual void start(){
+		UBRR0 = 0;
+		UCSR0C = _BV(UMSEL01) | _BV(UMSEL00) | _BV(UCPHA0) | _BV(UCPOL0);
+		UCSR0B = _BV(TXEN0);
+		UBRR0 = F_CPU / 2 / HT1632C_SERIAL_CLOCK - 1;
+	}
+
+	// A transaction is at least a command: 12 bits, so a byte was sent
+	virtual void stop(){
+		while(!(UCSR0A & _BV(TXC0)));
+		UCSR0B = 0;
+	}
+
+	virtual void shiftOut(uint8_t data){
+		while(!(UCSR0A & _BV(UDRE0)));
+		UCSR0A |= _BV(TXC0);
+		UDR0 = data;
+	}
+};
+
+#endif
+
+// Shortest time a plane of the least weight is shown (us)
+#define HT1632C_GRAY_PERIOD 1000
+
+// Memory for the bit planes of panels chained as one display
+#define HT1632C_GRAY_MEMORY(bits, panels) ((bits) * WIDTHSIZE * (panels))
+
+// Gray levels with binary code modulation: BITS (2 to 4) bit planes, and
+// plane n is shown 2^n times longer than plane 0. update() shows the next
+// plane when the time of the current one is over. Only the pixels that
+// differ between two planes are sent, so a plane costs less than a whole
+// frame. With usePwm(true) the planes are shown for the same time and the
+// PWM of the chips gives their weight instead: a cycle is BITS periods
+// instead of 2^BITS - 1, for a PWM command per plane. Call update() from
+// a tick or a timer interrupt, with no other writes to the display while
+// the planes are shown. The display must be constructed first
+template<uint8_t BITS>
+class DFRobot_HT1632C_Gray{
+public:
+	// A single panel. On chained panels it does nothing: they need memory
+	DFRobot_HT1632C_Gray(DFRobot_HT1632C &display) : display(display){
+		boolean single = display.getWidth() == WIDTHSIZE && display.getHeight() == HEIGHTSIZE;
+		init(single ? panel : NULL);
+	}
+
+	// Chained panels, memory is HT1632C_GRAY_MEMORY(BITS, columns * rows) bytes
+	DFRobot_HT1632C_Gray(DFRobot_HT1632C &display, uint8_t *memory) : display(display){
+		init(memory);
+	}
+
+	void setPixel(uint8_t x, uint8_t y, uint8_t level){
+		if(!planes || x >= display.getWidth() || y >= display.getHeight()) return;
+		uint16_t offset = (uint16_t)x * (display.getHeight() >> 3) + (y >> 3);
+		uint8_t bit = 0x80 >> (y & 7);
+		for(uint8_t p=0; p<BITS; p++, level >>= 1, offset += planeSize){
+			if(level & 1) planes[offset] |= bit;
+			else planes[offset] &= ~bit;
+		}
+	}
+
+	uint8_t getPixel(uint8_t x, uint8_t y){
+		if(!planes || x >= display.getWidth() || y >= display.getHeight()) return 0;
+		uint16_t offset = (uint16_t)x * (display.getHeight() >> 3) + (y >> 3);
+		uint8_t level = 0;
+		for(uint8_t p=BITS; p>0; p--){
+			level = (level << 1) | ((planes[(p-1) * planeSize + offset] & (0x80 >> (y & 7))) ? 1 : 0);
+		}
+		return level;
+	}
+
+	void clear(){
+		if(planes) memset(planes, 0, BITS * planeSize);
+	}
+
+	// A plane, laid out as DFRobot_HT1632C::getBuffer(). NULL without memory
+	uint8_t *getPlane(uint8_t bit) {return planes ? planes + bit * planeSize : NULL;}
+
+	void setPeriod(unsigned int us) {period = us;}
+	void usePwm(boolean state) {pwm = state;}
+
+	// Returns true when a plane was sent
+	boolean update(){
+		unsigned long now = micros();
+		if(!planes || now - start < length) return false;
+
+		// Late by more than a plane: start again from now
+		start = now - start < 2 * length ? start + length : now;
+		plane = plane + 1 < BITS ? plane + 1 : 0;
+		length = pwm ? period : (unsigned long)period << plane;
+
+		display.show(planes + plane * planeSize);
+		if(pwm) display.setPwm((16 >> (BITS - 1 - plane)) - 1);
+		return true;
+	}
+
+private:
+	DFRobot_HT1632C &display;
+	uint8_t panel[HT1632C_GRAY_MEMORY(BITS, 1)]; // The planes of a single panel
+	uint8_t *planes; // BITS planes of planeSize bytes, NULL if they do not fit
+	uint16_t planeSize;
+	uint8_t plane;
+	unsigned int period;
+	boolean pwm;
+	unsigned long start, length;
+
+	void init(uint8_t *memory){
+		planes = memory;
+		planeSize = planes ? (uint16_t)display.getWidth() * (display.getHeight() >> 3) : 0;
+		clear();
+		plane = BITS - 1;
+		period = HT1632C_GRAY_PERIOD;
+		pwm = false;
+		start = 0;
+		length = 0;
+	}
+};
+
 
 extern const byte FONT_8X4 [] PROGMEM;
 extern int FONT_8X4_END [];
@@ -14,7 +14,8 @@
 
 DFRobot_HT1632C ht1632c = DFRobot_HT1632C(DATA, WR,CS);
 
-char str[] = " DFROBOT 2017";
+// The text stays in flash, scroll() reads its columns as they come in
+const char str[] PROGMEM = " DFROBOT 2017";
 
 void setup() {
   Serial.begin(115200);
@@ -27,6 +28,9 @@ void setup() {
 
 void loop() {
   // put your main code here, to run repeatedly:
-  ht1632c.print(str,50);
-  //delay(100);
+  // updateScroll() does not wait: the loop is free for other work.
+  // print(text, 50) would scroll it and only return once it has gone
+  if(!ht1632c.updateScroll()){
+    ht1632c.scroll((const __FlashStringHelper *)str, 50);
+  }
 }
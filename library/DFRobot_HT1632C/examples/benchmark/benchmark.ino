@@ -0,0 +1,90 @@
+#include "DFRobot_HT1632C.h"
+
+// Time of a full writeScreen() with digitalWrite() pins and with
+// DFRobot_HT1632C_Fast (port registers on the Uno, Nano and Pro Mini),
+// then of a flush() that only sends a pixel going back and forth
+
+#if defined( ESP_PLATFORM ) || defined( ARDUINO_ARCH_FIREBEETLE8266 )  //FireBeetle-ESP32 FireBeetle-ESP8266
+#define DATA D6
+#define CS D2
+#define WR D7
+#else
+#define DATA 6
+#define CS 2
+#define WR 7
+#endif
+
+#define FRAMES 100
+
+DFRobot_HT1632C ht1632c = DFRobot_HT1632C(DATA, WR, CS);
+DFRobot_HT1632C_Fast<DATA, WR, CS> fast;
+#ifdef HT1632C_PORT_PINS
+// DATA on 11 and WR on 13 to see it, the timing does not need the display
+DFRobot_HT1632C_SPI<CS> spi;
+#endif
+
+unsigned long frameTime(DFRobot_HT1632C &display){
+  display.begin();
+  display.isLedOn(true);
+  display.fillScreen();
+
+  unsigned long start = micros();
+  for(int i = 0; i < FRAMES; i++){
+    display.writeScreen();
+  }
+  return (micros() - start) / FRAMES;
+}
+
+unsigned long flushTime(DFRobot_HT1632C &display){
+  display.clearStats();
+
+  unsigned long start = micros();
+  for(int i = 0; i < FRAMES; i++){
+    if(i & 1) display.setPixel(10, 3);
+    else display.clrPixel(10, 3);
+    display.flush();
+  }
+  return (micros() - start) / FRAMES;
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  unsigned long slow = frameTime(ht1632c);
+  unsigned long quick = frameTime(fast);
+
+  Serial.print("digitalWrite:  ");
+  Serial.print(slow);
+  Serial.print(" us, ");
+  Serial.print(slow * clockCyclesPerMicrosecond());
+  Serial.println(" cycles per frame");
+
+  Serial.print("Fast:          ");
+  Serial.print(quick);
+  Serial.print(" us, ");
+  Serial.print(quick * clockCyclesPerMicrosecond());
+  Serial.println(" cycles per frame");
+
+  Serial.print("Speed-up:      x");
+  Serial.println((float)slow / quick);
+
+#ifdef HT1632C_PORT_PINS
+  unsigned long hardware = frameTime(spi);
+  Serial.print("SPI:           ");
+  Serial.print(hardware);
+  Serial.print(" us, ");
+  Serial.print(hardware * clockCyclesPerMicrosecond());
+  Serial.println(" cycles per frame");
+#endif
+
+  unsigned long pixel = flushTime(fast);
+  Serial.print("Fast flush():  ");
+  Serial.print(pixel);
+  Serial.print(" us, ");
+  Serial.print(fast.getStats().frameBits);
+  Serial.println(" bits per frame instead of 394");
+}
+
+void loop() {
+
+}
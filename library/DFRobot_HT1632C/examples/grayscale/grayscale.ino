@@ -0,0 +1,69 @@
+#include "DFRobot_HT1632C.h"
+
+// Eight gray levels with bit planes, and what they cost: every two
+// seconds it prints the cycles of planes per second and the time spent
+// in update(). Send 'p' to switch the PWM weighting on and off
+
+#if defined( ESP_PLATFORM ) || defined( ARDUINO_ARCH_FIREBEETLE8266 )  //FireBeetle-ESP32 FireBeetle-ESP8266
+#define DATA D6
+#define CS D2
+#define WR D7
+#else
+#define DATA 6
+#define CS 2
+#define WR 7
+#endif
+
+#define BITS 3
+
+DFRobot_HT1632C_Fast<DATA, WR, CS> ht1632c;
+// Chained panels need the memory of their planes:
+//   uint8_t planes[HT1632C_GRAY_MEMORY(BITS, PANELS)];
+//   DFRobot_HT1632C_Gray<BITS> gray(ht1632c, planes);
+DFRobot_HT1632C_Gray<BITS> gray(ht1632c);
+
+boolean pwm = false;
+unsigned long start, busy, planes;
+
+void setup() {
+  Serial.begin(115200);
+  ht1632c.begin();
+  ht1632c.isLedOn(true);
+  ht1632c.clearScreen();
+
+  // Darker to the left, a dot of every level at the bottom
+  for(uint8_t x = 0; x < 24; x++){
+    for(uint8_t y = 0; y < 6; y++){
+      gray.setPixel(x, y, x * (1 << BITS) / 24);
+    }
+    gray.setPixel(x, 7, x % (1 << BITS));
+  }
+  start = micros();
+}
+
+void loop() {
+  unsigned long before = micros();
+  if(gray.update()){
+    busy += micros() - before;
+    planes++;
+  }
+
+  if(Serial.read() == 'p'){
+    pwm = !pwm;
+    gray.usePwm(pwm);
+    if(!pwm) ht1632c.setPwm(15);
+  }
+
+  unsigned long time = micros() - start;
+  if(time >= 2000000){
+    Serial.print(pwm ? "PWM:  " : "Time: ");
+    Serial.print(planes * 1000000.0 / time / BITS);
+    Serial.print(" cycles/s, ");
+    Serial.print(planes ? busy / planes : 0);
+    Serial.print(" us per plane, CPU ");
+    Serial.print(busy * 100.0 / time);
+    Serial.println(" %");
+    start = micros();
+    busy = planes = 0;
+  }
+}
@@ -0,0 +1,39 @@
+#include "DFRobot_HT1632C.h"
+
+// Three panels side by side as one 72x8 display: they share DATA and WR,
+// every panel has its own CS
+
+#if defined( ESP_PLATFORM ) || defined( ARDUINO_ARCH_FIREBEETLE8266 )  //FireBeetle-ESP32 FireBeetle-ESP8266
+#define DATA D6
+#define WR D7
+const uint8_t cs[] = {D2, D3, D4};
+#else
+#define DATA 6
+#define WR 7
+const uint8_t cs[] = {2, 3, 4};
+#endif
+
+#define PANELS 3
+
+uint8_t memory[HT1632C_MEMORY(PANELS)];
+DFRobot_HT1632C ht1632c = DFRobot_HT1632C(DATA, WR, cs, PANELS, 1, memory);
+
+char text[] = "HELLO STAGE";
+int x = 0;
+
+void setup() {
+  ht1632c.begin();
+  ht1632c.isLedOn(true);
+  ht1632c.clearScreen();
+}
+
+void loop() {
+  // The text goes over the borders of the panels, only the panels that
+  // change are written (clearScreen() would send the whole display)
+  memset(ht1632c.getBuffer(), 0, sizeof(memory) / 3);
+  ht1632c.drawText(text, x, 0, FONT_8X4, FONT_8X4_END, FONT_8X4_HEIGHT);
+  ht1632c.flush();
+
+  if(--x < -ht1632c.getTextWidth(text, FONT_8X4_END, FONT_8X4_HEIGHT)) x = ht1632c.getWidth();
+  delay(40);
+}
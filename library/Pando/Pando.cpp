@@ -8,7 +8,12 @@
 
 
 #include "Pando.h"
+#include "Pando_gesture_code.h"
 #include <Oscillator.h>
+
+#if defined(__AVR__)
+  #include <util/atomic.h>
+#endif
 // #include <US.h>
 
 
@@ -20,6 +25,24 @@ void Pando::init(int YL, int YR, int RL, int RR, bool load_calibration, int Nois
   servo_pins[2] = RL;
   servo_pins[3] = RR;
 
+  motion = MOVE_HOME;
+  gesture_playing = -1;
+
+  preemptions = 0;
+  waiting = false;
+  eyes = -1;
+  eyes_before = -1;
+  preempt_latency = 0;
+  preempt_latency_max = 0;
+
+#ifdef PANDO_WATCHDOG
+  watched = this;
+  watchdog_event.count = 0;
+  Watchdog::begin(_watchdogExpired);
+#endif
+
+  for (int i = 0; i < 4; i++) servo_position[i] = 90;
+
   attachServos();
   isPandoResting=false;
 
@@ -30,8 +53,6 @@ void Pando::init(int YL, int YR, int RL, int RR, bool load_calibration, int Nois
       servo[i].SetTrim(servo_trim);
     }
   }
-  
-  for (int i = 0; i < 4; i++) servo_position[i] = 90;
 
   // US sensor init with the pins:
   // us.init(USTrigger, USEcho);
@@ -53,10 +74,18 @@ void Pando::init(int YL, int YR, int RL, int RR, bool load_calibration, int Nois
 //-- ATTACH & DETACH FUNCTIONS ----------------------------------//
 ///////////////////////////////////////////////////////////////////
 void Pando::attachServos(){
-    servo[0].attach(servo_pins[0]);
-    servo[1].attach(servo_pins[1]);
-    servo[2].attach(servo_pins[2]);
-    servo[3].attach(servo_pins[3]);
+    //-- A released servo (home, OP_DETACH, the watchdog) comes back
+    //-- where the tracks left it, not at 90
+    for (int i = 0; i < 4; i++) {
+      if (servo[i].attached()) continue;
+      servo[i].attach(servo_pins[i]);
+      servo[i].SetPosition(servo_position[i]);
+    }
+
+#ifdef PANDO_WATCHDOG
+    Watchdog::arm();   //-- The servos hold torque: the tick must go on
+    Watchdog::setIdle(servo_track == TRACK_IDLE);
+#endif
 }
 
 void Pando::detachServos(){
@@ -64,6 +93,10 @@ void Pando::detachServos(){
     servo[1].detach();
     servo[2].detach();
     servo[3].detach();
+
+#ifdef PANDO_WATCHDOG
+    Watchdog::disarm();
+#endif
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -90,25 +123,8 @@ void Pando::saveTrimsOnEEPROM() {
 ///////////////////////////////////////////////////////////////////
 void Pando::_moveServos(int time, int  servo_target[]) {
 
-  attachServos();
-  if(getRestState()==true){
-        setRestState(false);
-  }
-
-  if(time>10){
-    for (int i = 0; i < 4; i++) increment[i] = ((servo_target[i]) - servo_position[i]) / (time / 10.0);
-    final_time =  millis() + time;
-
-    for (int iteration = 1; millis() < final_time; iteration++) {
-      partial_time = millis() + 10;
-      for (int i = 0; i < 4; i++) servo[i].SetPosition(servo_position[i] + (iteration * increment[i]));
-      while (millis() < partial_time); //pause
-    }
-  }
-  else{
-    for (int i = 0; i < 4; i++) servo[i].SetPosition(servo_target[i]);
-  }
-  for (int i = 0; i < 4; i++) servo_position[i] = servo_target[i];
+  _startPose(time, servo_target);
+  while (_updateServos()) _tick();
 }
 
 
@@ -120,32 +136,321 @@ void Pando::oscillateServos(int A[4], int O[4], int T, double phase_diff[4], flo
     servo[i].SetT(T);
     servo[i].SetPh(phase_diff[i]);
   }
+  PROFILE_BEGIN(PROF_OSCILLATE, T*cycle, servo[0].getTS());
+
+  uint8_t epoch = preemptions;
   double ref=millis();
-   for (double x=ref; x<=T*cycle+ref; x=millis()){
+   for (double x=ref; x<=T*cycle+ref && preemptions==epoch; x=millis()){
      for (int i=0; i<4; i++){
-        servo[i].refresh();
+        if (servo[i].refresh() && i==0) PROFILE_TICK();
      }
+     _tick();
   }
+
+  PROFILE_END();
 }
 
 
-void Pando::_execute(int A[4], int O[4], int T, double phase_diff[4], float steps = 1.0){
+//-- Loads the gait in the servo track. Unless the track is deferred
+//-- (a timeline is starting it), it waits for the gait to end
+void Pando::_execute(int A[4], int O[4], int T, double phase_diff[4], float steps, int gait, int dir){
+
+  //-- A resting robot is standing still: good time to look at the ground
+  if (slope_compensation && getRestState()==true) measureSlope();
+
+  _stopServos();
+  motion = gait;
 
   attachServos();
   if(getRestState()==true){
         setRestState(false);
   }
 
+  if (steps <= 0) return;
+
+  for (int i = 0; i < 4; i++) {
+    gait_A[i] = A[i];
+    gait_O[i] = O[i];
+    gait_phase[i] = phase_diff[i];
+    if (slope_compensation) gait_O[i] += slope_bias[i];
+  }
+  gait_hips[0] = A[0];
+  gait_hips[1] = A[1];
+  gait_T = T;
+  gait_steps = steps;
+  gait_dir = dir;
+  gait_cycle = 0;
 
-  int cycles=(int)steps;    
+  PROFILE_BEGIN(PROF_EXECUTE, T*steps, servo[0].getTS());
 
-  //-- Execute complete cycles
-  if (cycles >= 1) 
-    for(int i = 0; i < cycles; i++) 
-      oscillateServos(A,O, T, phase_diff);
-      
-  //-- Execute the final not complete cycle    
-  oscillateServos(A,O, T, phase_diff,(float)steps-cycles);
+  _setServoTrack(TRACK_GAIT);
+  _startCycle();
+
+  if (!deferred)
+    while (_updateServos()) _tick();
+}
+
+
+
+///////////////////////////////////////////////////////////////////
+//-- MOTION TRACKS ----------------------------------------------//
+///////////////////////////////////////////////////////////////////
+//-- Poses, gaits and sounds are started by a _start function and
+//-- advanced by an _update function that never blocks. The blocking
+//-- motions loop on the _update function, the timelines call it
+//-- once per update()
+
+//-- _moveServos() without the wait
+void Pando::_startPose(int time, int servo_target[4]){
+
+  _stopServos();
+
+  attachServos();
+  if(getRestState()==true){
+        setRestState(false);
+  }
+
+  PROFILE_BEGIN(PROF_MOVE, time, 10);
+
+  for (int i = 0; i < 4; i++) {
+    pose_from[i] = servo_position[i];
+    pose_to[i] = servo_target[i];
+  }
+  pose_time = time;
+  servo_start = millis();
+  servo_sample = servo_start;
+  servo_home = false;
+  _setServoTrack(TRACK_POSE);
+}
+
+//-- Program the oscillators for the next gait cycle (the last one may be partial)
+void Pando::_startCycle(){
+
+  gait_part = (gait_cycle < (int)gait_steps) ? 1 : gait_steps - (int)gait_steps;
+
+  if (motion == GAIT_WALK) _steer(gait_A, gait_hips, gait_dir);
+
+  for (int i=0; i<4; i++) {
+    servo[i].SetO(gait_O[i]);
+    servo[i].SetA(gait_A[i]);
+    servo[i].SetT(gait_T);
+    servo[i].SetPh(gait_phase[i]);
+  }
+  PROFILE_BEGIN(PROF_OSCILLATE, gait_T*gait_part, servo[0].getTS());
+
+  servo_start = millis();
+}
+
+//-- Advance the servo track. Returns false when it is idle
+bool Pando::_updateServos(){
+
+  unsigned long now = millis();
+
+  switch (servo_track) {
+
+    case TRACK_POSE:
+      if (pose_time > 10 && now - servo_start < pose_time) {
+        if (now - servo_sample < 10) return true;
+        servo_sample = now;
+        PROFILE_TICK();
+
+        for (int i = 0; i < 4; i++) {
+          servo_position[i] = pose_from[i] + (long)(pose_to[i] - pose_from[i]) * (long)(now - servo_start) / pose_time;
+          servo[i].SetPosition(servo_position[i]);
+        }
+        return true;
+      }
+
+      for (int i = 0; i < 4; i++) {
+        servo_position[i] = pose_to[i];
+        servo[i].SetPosition(servo_position[i]);
+      }
+      _setServoTrack(TRACK_IDLE);
+      PROFILE_END();
+
+      if (servo_home) {
+        detachServos();
+        isPandoResting=true;
+      }
+      return false;
+
+    case TRACK_GAIT:
+      for (int i=0; i<4; i++){
+        if (servo[i].refresh() && i==0) PROFILE_TICK();
+      }
+      if (now - servo_start <= gait_T*gait_part) return true;
+
+      PROFILE_END();
+      _countCycles(motion, gait_dir, gait_part);
+
+      if (++gait_cycle < gait_steps) {
+        _startCycle();
+        return true;
+      }
+
+      //-- Poses go on from where the gait left the legs
+      for (int i = 0; i < 4; i++) servo_position[i] = servo[i].getPosition();
+      _setServoTrack(TRACK_IDLE);
+      PROFILE_END();
+      return false;
+  }
+
+  return false;
+}
+
+//-- Stop the servo track. The servos stay where they are, and the
+//-- odometry counts the part of the cycle the gait went through
+void Pando::_stopServos(){
+
+  if (servo_track == TRACK_GAIT) {
+    PROFILE_END();
+    float elapsed = (float)(millis() - servo_start) / gait_T;
+    _countCycles(motion, gait_dir, elapsed < gait_part ? elapsed : gait_part);
+    for (int i = 0; i < 4; i++) servo_position[i] = servo[i].getPosition();
+  }
+  if (servo_track != TRACK_IDLE) PROFILE_END();
+
+  _setServoTrack(TRACK_IDLE);
+}
+
+//-- Between motions the servos only hold a pose: the watchdog gives the
+//-- sketch its longer idle timeout
+void Pando::_setServoTrack(uint8_t track){
+
+  servo_track = track;
+
+#ifdef PANDO_WATCHDOG
+  Watchdog::setIdle(track == TRACK_IDLE);
+#endif
+}
+
+//-- Oscillating gait by id (GAIT_*)
+void Pando::_playGait(int gait, float steps, int T, int h, int dir){
+
+  switch (gait) {
+    case GAIT_WALK:           walk(steps, T, dir); break;
+    case GAIT_TURN:           turn(steps, T, dir); break;
+    case GAIT_MOONWALKER:     moonwalker(steps, T, h, dir); break;
+    case GAIT_CRUSAITO:       crusaito(steps, T, h, dir); break;
+    case GAIT_FLAPPING:       flapping(steps, T, h, dir); break;
+    case GAIT_UPDOWN:         updown(steps, T, h); break;
+    case GAIT_SWING:          swing(steps, T, h); break;
+    case GAIT_TIPTOE_SWING:   tiptoeSwing(steps, T, h); break;
+    case GAIT_JITTER:         jitter(steps, T, h); break;
+    case GAIT_ASCENDING_TURN: ascendingTurn(steps, T, h); break;
+  }
+}
+
+//-- _tone() without the wait
+void Pando::_startTone(int frequency, int duration, int silence){
+
+  if (silence == 0) silence = 1;
+
+  tone(pinBuzzer, frequency, duration);
+  sound_next = millis() + duration + silence;
+  sound_track = TRACK_TONE;
+}
+
+//-- bendTones() without the wait. prop is given in thousandths
+void Pando::_startBend(int initFrequency, int finalFrequency, int prop, int noteDuration, int silence){
+
+  if (silence == 0) silence = 1;
+
+  bend_up = initFrequency < finalFrequency;
+  bend_freq = initFrequency;
+  bend_first = initFrequency;
+  bend_final = finalFrequency;
+  bend_prop = prop;
+  bend_note = noteDuration;
+  bend_silence = silence;
+  bend_count = 1;
+
+  sound_next = millis();
+  sound_track = TRACK_BEND;
+}
+
+//-- Advance the sound track. Returns false when it is idle
+bool Pando::_updateSound(){
+
+  if (sound_track == TRACK_IDLE) return false;
+  if ((long)(millis() - sound_next) < 0) return true;
+
+  if (sound_track == TRACK_BEND && (bend_up ? bend_freq < bend_final : bend_freq > bend_final)) {
+    tone(pinBuzzer, bend_freq, bend_note);
+    sound_next = millis() + bend_note + bend_silence;
+
+    int next = bend_up ? (long)bend_freq * bend_prop / 1000 : (long)bend_freq * 1000 / bend_prop;
+    if (next == bend_freq) next += bend_up ? 1 : -1;   //-- Too low to bend by prop
+    bend_freq = next;
+    return true;
+  }
+
+  //-- Next bend of an OP_BENDS run
+  if (sound_track == TRACK_BEND && --bend_count > 0) {
+    bend_first += bend_step;
+    bend_final += bend_step;
+    bend_freq = bend_first;
+    bend_up = bend_first < bend_final;
+    return true;
+  }
+
+  sound_track = TRACK_IDLE;
+  return false;
+}
+
+
+
+//-- Work that has to go on while a motion keeps the loop busy
+void Pando::_tick(){
+
+  _background();
+
+  //-- A request that beats the running motion plays right now, inside the
+  //-- blocking call. The call gives up when it sees preemptions change
+  if (request_gesture >= 0 && _takeRequest())
+    while (_updateTimeline()) _tick();
+}
+
+//-- The part of the tick that never blocks
+void Pando::_background(){
+
+#ifdef PANDO_WATCHDOG
+  Watchdog::kick();
+#endif
+
+  //-- The gyro integrates the yaw, so it needs regular updates
+  if (gyro != NULL && millis() - gyro_time >= GYRO_PERIOD) {
+    gyro_time = millis();
+    gyro->update();
+  }
+
+  _updateEyes();
+
+  if (tick_hook != NULL) tick_hook();
+}
+
+//-- Like delay(), but the tick goes on. A preemption cuts it short
+void Pando::_wait(unsigned long time){
+
+  uint8_t epoch = preemptions;
+  bool nested = waiting;
+  waiting = true;
+
+  unsigned long start = millis();
+  while (millis() - start < time && preemptions == epoch) _tick();
+
+  waiting = nested;
+}
+
+bool Pando::update(){
+
+  //-- Nothing blocks here: a preempting gesture is just loaded
+  if (request_gesture >= 0) _takeRequest();
+
+  bool busy = _updateTimeline();
+  _background();
+
+  return busy;
 }
 
 
@@ -157,8 +462,11 @@ void Pando::home(){
 
   if(isPandoResting==false){ //Go to rest position only if necessary
 
+    motion = MOVE_HOME;
+    uint8_t epoch = preemptions;
     int homes[4]={90, 90, 90, 90}; //All the servos at rest position
     _moveServos(500,homes);   //Move the servos in half a second
+    if (preemptions != epoch) return;
 
     detachServos();
     isPandoResting=true;
@@ -188,8 +496,11 @@ void Pando::setRestState(bool state){
 //---------------------------------------------------------
 void Pando::jump(float steps, int T){
 
+  motion = MOVE_JUMP;
+  uint8_t epoch = preemptions;
   int up[]={90,90,150,30};
   _moveServos(T,up);
+  if (preemptions != epoch) return;
   int down[]={90,90,90,90};
   _moveServos(T,down);
 }
@@ -216,7 +527,7 @@ void Pando::walk(float steps, int T, int dir){
   double phase_diff[4] = {0, 0, DEG2RAD(dir * -90), DEG2RAD(dir * -90)};
 
   //-- Let's oscillate the servos!
-  _execute(A, O, T, phase_diff, steps);  
+  _execute(A, O, T, phase_diff, steps, GAIT_WALK, dir);  
 }
 
 
@@ -248,7 +559,7 @@ void Pando::turn(float steps, int T, int dir){
   }
     
   //-- Let's oscillate the servos!
-  _execute(A, O, T, phase_diff, steps); 
+  _execute(A, O, T, phase_diff, steps, GAIT_TURN, dir); 
 }
 
 
@@ -261,6 +572,8 @@ void Pando::turn(float steps, int T, int dir){
 //---------------------------------------------------------
 void Pando::bend(int steps, int T, int dir){
 
+  motion = MOVE_BEND;
+
   //Parameters of all the movements. Default: Left bend
   int bend1[4]={90, 90, 62, 35}; 
   int bend2[4]={90, 90, 62, 105};
@@ -282,14 +595,22 @@ void Pando::bend(int steps, int T, int dir){
   int T2=800; 
 
   //Bend movement
-  for (int i=0;i<steps;i++)
+  PROFILE_BEGIN(PROF_BEND, (long)steps*T, 10);
+
+  //-- A preempting gesture has homed the legs: do not move them again
+  uint8_t epoch = preemptions;
+  for (int i=0;i<steps && preemptions==epoch;i++)
   {
     _moveServos(T2/2,bend1);
+    if (preemptions != epoch) break;
     _moveServos(T2/2,bend2);
-    delay(T*0.8);
+    if (preemptions != epoch) break;
+    _wait(T*0.8);
+    if (preemptions != epoch) break;
     _moveServos(500,homes);
   }
 
+  PROFILE_END();
 }
 
 
@@ -302,6 +623,8 @@ void Pando::bend(int steps, int T, int dir){
 //---------------------------------------------------------
 void Pando::shakeLeg(int steps,int T,int dir){
 
+  motion = MOVE_SHAKE_LEG;
+
   //This variable change the amount of shakes
   int numberLegMoves=2;
 
@@ -328,22 +651,26 @@ void Pando::shakeLeg(int steps,int T,int dir){
   T=T-T2;
   T=max(T,200*numberLegMoves);  
 
-  for (int j=0; j<steps;j++)
+  uint8_t epoch = preemptions;
+  for (int j=0; j<steps && preemptions==epoch;j++)
   {
   //Bend movement
   _moveServos(T2/2,shake_leg1);
+  if (preemptions != epoch) break;
   _moveServos(T2/2,shake_leg2);
   
     //Shake movement
-    for (int i=0;i<numberLegMoves;i++)
+    for (int i=0;i<numberLegMoves && preemptions==epoch;i++)
     {
     _moveServos(T/(2*numberLegMoves),shake_leg3);
+    if (preemptions != epoch) break;
     _moveServos(T/(2*numberLegMoves),shake_leg2);
     }
+    if (preemptions != epoch) break;
     _moveServos(500,homes); //Return to home position
   }
   
-  delay(T);
+  if (preemptions == epoch) _wait(T);
 }
 
 
@@ -366,7 +693,7 @@ void Pando::updown(float steps, int T, int h){
   double phase_diff[4] = {0, 0, DEG2RAD(-90), DEG2RAD(90)};
   
   //-- Let's oscillate the servos!
-  _execute(A, O, T, phase_diff, steps); 
+  _execute(A, O, T, phase_diff, steps, GAIT_UPDOWN); 
 }
 
 
@@ -386,7 +713,7 @@ void Pando::swing(float steps, int T, int h){
   double phase_diff[4] = {0, 0, DEG2RAD(0), DEG2RAD(0)};
   
   //-- Let's oscillate the servos!
-  _execute(A, O, T, phase_diff, steps); 
+  _execute(A, O, T, phase_diff, steps, GAIT_SWING); 
 }
 
 
@@ -406,7 +733,7 @@ void Pando::tiptoeSwing(float steps, int T, int h){
   double phase_diff[4] = {0, 0, 0, 0};
   
   //-- Let's oscillate the servos!
-  _execute(A, O, T, phase_diff, steps); 
+  _execute(A, O, T, phase_diff, steps, GAIT_TIPTOE_SWING); 
 }
 
 
@@ -430,7 +757,7 @@ void Pando::jitter(float steps, int T, int h){
   double phase_diff[4] = {DEG2RAD(-90), DEG2RAD(90), 0, 0};
   
   //-- Let's oscillate the servos!
-  _execute(A, O, T, phase_diff, steps); 
+  _execute(A, O, T, phase_diff, steps, GAIT_JITTER); 
 }
 
 
@@ -453,7 +780,7 @@ void Pando::ascendingTurn(float steps, int T, int h){
   double phase_diff[4] = {DEG2RAD(-90), DEG2RAD(90), DEG2RAD(-90), DEG2RAD(90)};
   
   //-- Let's oscillate the servos!
-  _execute(A, O, T, phase_diff, steps); 
+  _execute(A, O, T, phase_diff, steps, GAIT_ASCENDING_TURN); 
 }
 
 
@@ -483,7 +810,7 @@ void Pando::moonwalker(float steps, int T, int h, int dir){
   double phase_diff[4] = {0, 0, DEG2RAD(phi), DEG2RAD(-60 * dir + phi)};
   
   //-- Let's oscillate the servos!
-  _execute(A, O, T, phase_diff, steps); 
+  _execute(A, O, T, phase_diff, steps, GAIT_MOONWALKER, dir); 
 }
 
 
@@ -502,7 +829,7 @@ void Pando::crusaito(float steps, int T, int h, int dir){
   double phase_diff[4] = {90, 90, DEG2RAD(0), DEG2RAD(-60 * dir)};
   
   //-- Let's oscillate the servos!
-  _execute(A, O, T, phase_diff, steps); 
+  _execute(A, O, T, phase_diff, steps, GAIT_CRUSAITO, dir); 
 }
 
 
@@ -521,10 +848,239 @@ void Pando::flapping(float steps, int T, int h, int dir){
   double phase_diff[4] = {DEG2RAD(0), DEG2RAD(180), DEG2RAD(-90 * dir), DEG2RAD(90 * dir)};
   
   //-- Let's oscillate the servos!
-  _execute(A, O, T, phase_diff, steps); 
+  _execute(A, O, T, phase_diff, steps, GAIT_FLAPPING, dir); 
+}
+
+
+
+
+
+
+///////////////////////////////////////////////////////////////////
+//-- HEADING HOLD -----------------------------------------------//
+///////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------
+//-- Pando holdHeading: walk() keeps the robot on a yaw heading
+//--  Parameters:
+//--    heading: gyro yaw (degrees, as returned by Gyro::getAngleZ)
+//--  It can be changed while walking to follow a commanded yaw
+//---------------------------------------------------------
+void Pando::holdHeading(double heading){
+
+  if (!heading_hold) heading_integral = 0;
+  heading_target = heading;
+  heading_hold = true;
+}
+
+void Pando::holdCurrentHeading(){
+
+  if (gyro != NULL) holdHeading(gyro->getAngleZ());
+}
+
+void Pando::releaseHeading(){
+
+  heading_hold = false;
+}
+
+//---------------------------------------------------------
+//-- Pando getHeadingError: mean absolute heading error (degrees)
+//--  per gait cycle since the last resetHeadingError()
+//---------------------------------------------------------
+double Pando::getHeadingError(){
+
+  if (heading_cycles == 0) return 0;
+  return heading_error_sum / heading_cycles;
+}
+
+double Pando::getHeadingErrorMax(){
+
+  return heading_error_max;
+}
+
+void Pando::resetHeadingError(){
+
+  heading_error_sum = 0;
+  heading_error_max = 0;
+  heading_cycles = 0;
+}
+
+//---------------------------------------------------------
+//-- Adjust the hip amplitudes for the next gait cycle
+//--  A bigger left hip amplitude makes the robot describe a left
+//--  arc (see Pando::turn), so the error is split between both hips
+//--  Parameters:
+//--    A: amplitudes of the next cycle
+//--    hips: hip amplitudes of the gait, without steering
+//--    dir: FORWARD / BACKWARD
+//---------------------------------------------------------
+void Pando::_steer(int A[4], const int hips[2], int dir){
+
+  if (!heading_hold || gyro == NULL) return;
+
+  double error = heading_target - gyro->getAngleZ();
+  while (error > 180) error -= 360;
+  while (error < -180) error += 360;
+
+  heading_error_sum += abs(error);
+  if (abs(error) > heading_error_max) heading_error_max = abs(error);
+  heading_cycles++;
+
+  heading_integral = constrain(heading_integral + error, -HEADING_INTEGRAL_MAX, HEADING_INTEGRAL_MAX);
+
+  int correction = round(HEADING_KP * error + HEADING_KI * heading_integral);
+  correction = constrain(correction, -HEADING_MAX_CORRECTION, HEADING_MAX_CORRECTION);
+
+  //-- Walking backward the same hip asymmetry turns the other way
+  A[0] = hips[0] + dir * correction;
+  A[1] = hips[1] - dir * correction;
+}
+
+
+
+
+///////////////////////////////////////////////////////////////////
+//-- ODOMETRY ---------------------------------------------------//
+///////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------
+//-- Pando resetPose: set where Pando is now (mm, degrees)
+//--  Heading 0 looks along the x axis, positive to the left
+//---------------------------------------------------------
+void Pando::resetPose(double x, double y, double heading){
+
+  odometry.reset(x, y, heading);
+  if (gyro != NULL) odometry.setYawReference(gyro->getAngleZ());
+}
+
+double Pando::getPoseX(){
+
+  return odometry.getX();
 }
 
+double Pando::getPoseY(){
 
+  return odometry.getY();
+}
+
+double Pando::getPoseHeading(){
+
+  return odometry.getHeading();
+}
+
+//-- Distance (mm) from the estimated position to a point (e.g. the start mark)
+double Pando::getDistanceTo(double x, double y){
+
+  return odometry.distanceTo(x, y);
+}
+
+//-- Turn (degrees, positive to the left) needed to face a point
+double Pando::getBearingTo(double x, double y){
+
+  return odometry.bearingTo(x, y);
+}
+
+//-- Total distance (mm) walked since power on
+double Pando::getDistanceTravelled(){
+
+  return odometry.getDistance();
+}
+
+float Pando::getGaitCycles(int gait){
+
+  return odometry.getCycles(gait);
+}
+
+//---------------------------------------------------------
+//-- Pando calibrateGait: displacement of one cycle of a gait
+//--  Parameters:
+//--    gait: GAIT_WALK, GAIT_TURN...
+//--    forward, lateral: mm for dir = FORWARD / LEFT (lateral positive to the left)
+//--    turn: degrees per cycle (positive to the left), used when there is no gyro
+//---------------------------------------------------------
+void Pando::calibrateGait(int gait, int forward, int lateral, int turn){
+
+  odometry.calibrate(gait, forward, lateral, turn);
+}
+
+//-- A gait has done some cycles: move the pose estimate
+void Pando::_countCycles(int gait, int dir, float cycles){
+
+  if (gait == GAIT_NONE || cycles <= 0) return;
+
+  if (gyro != NULL) odometry.addCycles(gait, dir, cycles, gyro->getAngleZ());
+  else odometry.addCycles(gait, dir, cycles);
+}
+
+
+
+
+///////////////////////////////////////////////////////////////////
+//-- SLOPE COMPENSATION -----------------------------------------//
+///////////////////////////////////////////////////////////////////
+
+//---------------------------------------------------------
+//-- Pando setSlopeCompensation: bias the oscillator offsets of the
+//--  gaits with the ground inclination so Pando doesn't slide downhill
+//--  It needs a gyro (see attachGyro)
+//---------------------------------------------------------
+void Pando::setSlopeCompensation(bool state){
+
+  if (state && !slope_compensation) {
+    //-- Start the estimate from a direct reading
+    slope_pitch = slope_roll = 0;
+    if (gyro != NULL) {
+      gyro->update();
+      slope_pitch = gyro->getAngleX();
+      slope_roll = gyro->getAngleY();
+    }
+    _updateSlopeBias();
+  }
+  slope_compensation = state;
+}
+
+//---------------------------------------------------------
+//-- Pando measureSlope: read the inclination. Call it while Pando stands
+//--  still; it is also done before a gait that starts from rest
+//---------------------------------------------------------
+void Pando::measureSlope(){
+
+  if (gyro == NULL) return;
+
+  gyro->update();
+  slope_pitch += (gyro->getAngleX() - slope_pitch) * SLOPE_FILTER;
+  slope_roll += (gyro->getAngleY() - slope_roll) * SLOPE_FILTER;
+
+  //-- The biases are only recomputed when the ground really changed
+  if (abs(slope_pitch - slope_pitch_used) > SLOPE_THRESHOLD ||
+      abs(slope_roll - slope_roll_used) > SLOPE_THRESHOLD) _updateSlopeBias();
+}
+
+double Pando::getSlopePitch(){
+
+  return slope_pitch;
+}
+
+double Pando::getSlopeRoll(){
+
+  return slope_roll;
+}
+
+void Pando::_updateSlopeBias(){
+
+  slope_pitch_used = slope_pitch;
+  slope_roll_used = slope_roll;
+
+  //-- Roll: both feet lean to the uphill side (same sign, like swing)
+  //-- Pitch: more tiptoe for grip (opposite signs, like walk)
+  int lean = round(SLOPE_ROLL_GAIN * slope_roll);
+  int tiptoe = round(SLOPE_PITCH_GAIN * slope_pitch);
+
+  slope_bias[0] = 0;
+  slope_bias[1] = 0;
+  slope_bias[2] = constrain(lean + tiptoe, -SLOPE_MAX_BIAS, SLOPE_MAX_BIAS);
+  slope_bias[3] = constrain(lean - tiptoe, -SLOPE_MAX_BIAS, SLOPE_MAX_BIAS);
+}
 
 
 
@@ -533,6 +1089,17 @@ void Pando::flapping(float steps, int T, int h, int dir){
 //-- SENSORS FUNCTIONS  -----------------------------------------//
 ///////////////////////////////////////////////////////////////////
 
+//---------------------------------------------------------
+//-- Pando attachGyro: let Pando read the gyro while it moves
+//--  The gyro has to be started (gyro.begin()) by the sketch
+//---------------------------------------------------------
+void Pando::attachGyro(Gyro &gyro_sensor){
+
+  gyro = &gyro_sensor;
+  gyro_time = millis();
+  odometry.setYawReference(gyro->getAngleZ());
+}
+
 //---------------------------------------------------------
 //-- Pando getDistance: return Pando's ultrasonic sensor measure
 //---------------------------------------------------------
@@ -709,49 +1276,20 @@ double Pando::getBatteryVoltage(){
 //-- EYES & ANIMATIONS ----------------------------------------//
 ///////////////////////////////////////////////////////////////////
 
+//-- Expressions are frames in PROGMEM (see Pando_eyes.cpp): one copy and
+//-- one transfer to the display
 void Pando::putEyes(int eyeExpression) {
-  switch (eyeExpression) {
-      case smile:
-        smileEyes();
-        break;
-      case happyOpen:
-        happyOpenEyes();
-        break;
-      case happyClosed:
-        closeEyes();
-        break;
-      case heart:
-        loveEyes();
-        break;
-      case bigSurprise:
-        // do something
-        break;
-      case smallSurprise:
-        // do something
-        break;
-      case confused:
-        confusedEyes();
-        break;
-      case sad:
-        sadEyes();
-        break;
-      case sadOpen:
-        sadOpenEyes();
-        break;
-      case sadClosed:
-        sadCloseEyes();
-        break;   
-      case angry:
-        // do something
-        angryEyes();
-        break;
-      case fartLeft:
-        fartLeftEyes();
-        break;
-      case fartRight:
-        fartRightEyes();
-        break;
-  }
+  eye_animation = NULL;
+  tweening = false;
+  _dropBlink();
+  _drawEyes(eyeExpression);
+}
+
+void Pando::_drawEyes(int eyeExpression) {
+  if (!eyeFrame(eyeExpression, ht1632c.getBuffer())) return;
+
+  eyes = eyeExpression;
+  _flushEyes();
 }
 
 
@@ -775,12 +1313,8 @@ void Pando::_tone (float noteFrequency, long noteDuration, int silentDuration){
     // tone(10,261,500);
     // delay(500);
 
-      if(silentDuration==0){silentDuration=1;}
-
-      tone(Pando::pinBuzzer, noteFrequency, noteDuration);
-      delay(noteDuration);       //milliseconds to microseconds
-      //noTone(PIN_Buzzer);
-      delay(silentDuration);     
+      _startTone(noteFrequency, noteDuration, silentDuration);
+      while (_updateSound()) _tick();
 }
 
 
@@ -790,1518 +1324,853 @@ void Pando::bendTones (float initFrequency, float finalFrequency, float prop, lo
   //  bendTones (880, 2093, 1.02, 18, 1);
   //  bendTones (note_A5, note_C7, 1.02, 18, 0);
 
-  if(silentDuration==0){silentDuration=1;}
-
-  if(initFrequency < finalFrequency)
-  {
-      for (int i=initFrequency; i<finalFrequency; i=i*prop) {
-          _tone(i, noteDuration, silentDuration);
-      }
-
-  } else{
-
-      for (int i=initFrequency; i>finalFrequency; i=i/prop) {
-          _tone(i, noteDuration, silentDuration);
-      }
-  }
+  _startBend(initFrequency, finalFrequency, prop*1000+0.5, noteDuration, silentDuration);
+  while (_updateSound()) _tick();
 }
 
 
+//-- The songs are programs of sound operations (see Pando_gesture_code.h),
+//-- played on the sound track alone: a gesture or a motion that runs keeps
+//-- its eyes and its legs moving, and goes on after the song. A request
+//-- taken during the song cuts it short
 void Pando::sing(int songName){
-  switch(songName){
-
-    case S_connection:
-      _tone(note_E5, 50, 30);
-      _tone(note_E6, 55, 25);
-      _tone(note_A6, 60, 10);
-    break;
-
-    case S_disconnection:
-      _tone(note_E5, 50, 30);
-      _tone(note_A6, 55, 25);
-      _tone(note_E6, 50, 10);
-    break;
-
-    case S_buttonPushed:
-      bendTones (note_E6, note_G6, 1.03, 20, 2);
-      delay(30);
-      bendTones (note_E6, note_D7, 1.04, 10, 2);
-    break;
-
-    case S_mode1:
-      bendTones (note_E6, note_A6, 1.02, 30, 10);  //1318.51 to 1760
-    break;
-
-    case S_mode2:
-      bendTones (note_G6, note_D7, 1.03, 30, 10);  //1567.98 to 2349.32
-    break;
-
-    case S_mode3:
-      _tone(note_E6, 50, 100); //D6
-      _tone(note_G6, 50, 80);  //E6
-      _tone(note_D7, 300, 0);  //G6
-    break;
-
-    case S_surprise:
-      bendTones(800, 2150, 1.02, 10, 1);
-      bendTones(2149, 800, 1.03, 7, 1);
-    break;
-
-    case S_OhOoh:
-      bendTones(880, 2000, 1.04, 8, 3); //A5 = 880
-      delay(200);
-
-      for (int i=880; i<2000; i=i*1.04) {
-           _tone(note_B5,5,10);
-      }
-    break;
-
-    case S_OhOoh2:
-      bendTones(1880, 3000, 1.03, 8, 3);
-      delay(200);
-
-      for (int i=1880; i<3000; i=i*1.03) {
-          _tone(note_C6,10,10);
-      }
-    break;
-
-    case S_cuddly:
-      bendTones(700, 900, 1.03, 16, 4);
-      bendTones(899, 650, 1.01, 18, 7);
-    break;
-
-    case S_sleeping:
-      bendTones(100, 500, 1.04, 10, 10);
-      delay(500);
-      bendTones(400, 100, 1.04, 10, 1);
-    break;
-
-    case S_happy:
-      bendTones(1500, 2500, 1.05, 20, 8);
-      bendTones(2499, 1500, 1.05, 25, 8);
-    break;
-
-    case S_superHappy:
-      bendTones(2000, 6000, 1.05, 8, 3);
-      delay(50);
-      bendTones(5999, 2000, 1.05, 13, 2);
-    break;
-
-    case S_happy_short:
-      bendTones(1500, 2000, 1.05, 15, 8);
-      delay(100);
-      bendTones(1900, 2500, 1.05, 10, 8);
-    break;
-
-    case S_sad:
-      bendTones(880, 669, 1.02, 20, 200);
-    break;
-
-    case S_confused:
-      bendTones(1000, 1700, 1.03, 8, 2); 
-      bendTones(1699, 500, 1.04, 8, 3);
-      bendTones(1000, 1700, 1.05, 9, 10);
-    break;
-
-    case S_fart1:
-      bendTones(1600, 3000, 1.02, 2, 15);
-    break;
-
-    case S_fart2:
-      bendTones(2000, 6000, 1.02, 2, 20);
-    break;
-
-    case S_fart3:
-      bendTones(1600, 4000, 1.02, 2, 20);
-      bendTones(4000, 3000, 1.02, 2, 20);
-    break;
-
-  }
-}
-
-
-
-///////////////////////////////////////////////////////////////////
-//-- GESTURES ---------------------------------------------------//
-///////////////////////////////////////////////////////////////////
-
-void Pando::playGesture(int gesture){
-
-  int sadPos[4]=      {110, 70, 20, 160};
-  int bedPos[4]=      {100, 80, 60, 120};
-  int fartPos_1[4]=   {90, 90, 145, 122}; //rightBend
-  int fartPos_2[4]=   {90, 90, 80, 122};
-  int fartPos_3[4]=   {90, 90, 145, 80};
-  int confusedPos[4]= {110, 70, 90, 90};
-  int angryPos[4]=    {90, 90, 70, 110};
-  int headLeft[4]=    {110, 110, 90, 90};
-  int headRight[4]=   {70, 70, 90, 90};
-  int fretfulPos[4]=  {90, 90, 90, 110};
-  int bendPos_1[4]=   {90, 90, 70, 35};
-  int bendPos_2[4]=   {90, 90, 55, 35};
-  int bendPos_3[4]=   {90, 90, 42, 35};
-  int bendPos_4[4]=   {90, 90, 34, 35};
-  
-  switch(gesture){
-
-    case PandoHappy: 
-        _tone(note_E5,50,30);
-        // putMouth(smile);
-        putEyes(smile);
-        sing(S_happy_short);
-        swing(1,800,20); 
-        sing(S_happy_short);
-
-        home();
-        // putMouth(happyOpen);
-        putEyes(happyOpen);
-    break;
-
-
-    case PandoSuperHappy:
-        // putMouth(happyOpen);
-        putEyes(happyOpen);
-        sing(S_happy);
-        // putMouth(happyClosed);
-        putEyes(happyClosed);
-        tiptoeSwing(1,500,20);
-        // putMouth(happyOpen);
-        putEyes(happyOpen);
-        sing(S_superHappy);
-        // putMouth(happyClosed);
-        putEyes(happyClosed);
-        tiptoeSwing(1,500,20); 
-
-        home();  
-        // putMouth(happyOpen);
-        putEyes(happyOpen);
-    break;
-
-
-    case PandoSad: 
-        // putMouth(sad);
-        putEyes(sadOpen);
-        _moveServos(700, sadPos);     
-        bendTones(880, 830, 1.02, 20, 200);
-        // putMouth(sadClosed);
-        putEyes(sadClosed);
-        bendTones(830, 790, 1.02, 20, 200);  
-        // putMouth(sadOpen);
-        putEyes(sadOpen);
-        bendTones(790, 740, 1.02, 20, 200);
-        // putMouth(sadClosed);
-        putEyes(sadClosed);
-        bendTones(740, 700, 1.02, 20, 200);
-        // putMouth(sadOpen);
-        putEyes(sadOpen);
-        bendTones(700, 669, 1.02, 20, 200);
-        // putMouth(sad);
-        putEyes(sadOpen);
-        delay(500);
-
-        home();
-        delay(300);
-        // putMouth(happyOpen);
-        // putEyes(happyOpen);
-    break;
-
-
-    case PandoSleeping:
-        _moveServos(700, bedPos);
-
-        putEyes(happyClosed);     
-
-        for(int i=0; i<4;i++){
-          // putAnimationMouth(dreamMouth,0);
-          bendTones (100, 200, 1.04, 10, 10);
-          // putAnimationMouth(dreamMouth,1);
-          bendTones (200, 300, 1.04, 10, 10);  
-          // putAnimationMouth(dreamMouth,2);
-          bendTones (300, 500, 1.04, 10, 10);   
-          delay(500);
-          // putAnimationMouth(dreamMouth,1);
-          bendTones (400, 250, 1.04, 10, 1); 
-          // putAnimationMouth(dreamMouth,0);
-          bendTones (250, 100, 1.04, 10, 1); 
-          delay(500);
-        } 
-
-        // putMouth(lineMouth);
-        sing(S_cuddly);
-
-        home();  
-        // putMouth(happyOpen);
-        // putEyes(happyOpen);
-    break;
-
-
-    case PandoFart:
-        _moveServos(500,fartPos_1);
-        delay(300);     
-        // putMouth(lineMouth);
-        putEyes(fartLeft);
-        sing(S_fart1);  
-        // putMouth(tongueOut);
-        putEyes(fartRight);
-        delay(250);
-        _moveServos(500,fartPos_2);
-        delay(300);
-        // putMouth(lineMouth);
-        putEyes(fartLeft);
-        sing(S_fart2); 
-        // putMouth(tongueOut);
-        putEyes(fartRight);
-        delay(250);
-        _moveServos(500,fartPos_3);
-        delay(300);
-        // putMouth(lineMouth);
-        putEyes(fartLeft);
-        sing(S_fart3);
-        // putMouth(tongueOut);
-        putEyes(fartRight);    
-        delay(300);
-
-        home(); 
-        delay(500); 
-        // putMouth(happyOpen);
-        putEyes(happyOpen);
-    break;
-
-
-    case PandoConfused:
-        _moveServos(300, confusedPos); 
-        // putMouth(confused);
-        putEyes(confused);
-        sing(S_confused);
-        delay(500);
-
-        home();  
-        // putMouth(happyOpen);
-        // putEyes(happyOpen);
-    break;
-
-
-    case PandoLove:
-        // putMouth(heart);
-        putEyes(heart);
-        sing(S_cuddly);
-        crusaito(2,1500,15,1);
-
-        home(); 
-        sing(S_happy_short);  
-        // putMouth(happyOpen);
-        // putEyes(happyOpen);
-    break;
-
-
-    case PandoAngry: 
-        _moveServos(300, angryPos); 
-        // putMouth(angry);
-        putEyes(angry);
-
-        _tone(note_A5,100,30);
-        bendTones(note_A5, note_D6, 1.02, 7, 4);
-        bendTones(note_D6, note_G6, 1.02, 10, 1);
-        bendTones(note_G6, note_A5, 1.02, 10, 1);
-        delay(15);
-        bendTones(note_A5, note_E5, 1.02, 20, 4);
-        delay(400);
-        _moveServos(200, headLeft); 
-        bendTones(note_A5, note_D6, 1.02, 20, 4);
-        _moveServos(200, headRight); 
-        bendTones(note_A5, note_E5, 1.02, 20, 4);
-
-        home();  
-        // putMouth(happyOpen);
-        // putEyes(happyOpen);
-    break;
-
-
-    case PandoFretful: 
-        // putMouth(angry);
-        putEyes(angry);
-
-        bendTones(note_A5, note_D6, 1.02, 20, 4);
-        bendTones(note_A5, note_E5, 1.02, 20, 4);
-        delay(300);
-
-        // putMouth(lineMouth);
-        // putEyes(happyClosed);
-
-
-        for(int i=0; i<4; i++){
-          _moveServos(100, fretfulPos);   
-          home();
-        }
-
-        // putMouth(angry);
-        // putEyes(angry);
-
-        delay(500);
-
-        home();  
-        // putMouth(happyOpen);
-        // putEyes(happyOpen);
-    break;
-
 
-    case PandoMagic:
+  if (songName < 0 || songName >= SONGS) return;
 
-        //Initial note frecuency = 400
-        //Final note frecuency = 1000
-        
-        // Reproduce the animation four times
-        for(int i = 0; i<4; i++){ 
+  const uint8_t *song = (const uint8_t *)pgm_read_ptr(&song_code[songName]);
+  const uint8_t *loop = NULL;
+  uint8_t count = 0;
+  uint8_t epoch = preemptions;
 
-          int noteM = 400; 
+  while (true) {
+    uint8_t op = pgm_read_byte(song++);
+    switch (op) {
 
-            for(int index = 0; index<6; index++){
-              // putAnimationMouth(adivinawi,index);
-              bendTones(noteM, noteM+100, 1.04, 10, 10);    //400 -> 1000 
-              noteM+=100;
-            }
+      case OP_TONE: {
+        int frequency = (int16_t)pgm_read_word(song);
+        int duration = (int16_t)pgm_read_word(song + 2);
+        _startTone(frequency, duration, pgm_read_byte(song + 4));
+        song += 5;
+        break;
+      }
 
-            // clearMouth();
-            bendTones(noteM-100, noteM+100, 1.04, 10, 10);  //900 -> 1100
+      case OP_BEND:
+      case OP_BENDS: {
+        bool run = op == OP_BENDS;
+        int first = (int16_t)pgm_read_word(song);
+        int last = (int16_t)pgm_read_word(song + 2);    //-- The span for OP_BENDS
+        song += 4;
+        int step = run ? (int16_t)pgm_read_word(song) : 0;
+        uint8_t bends = run ? pgm_read_byte(song + 2) : 1;
+        if (run) song += 3;
+        _startBend(first, run ? first + last : last, 1000 + pgm_read_byte(song), pgm_read_byte(song + 1), pgm_read_byte(song + 2));
+        bend_step = step;
+        bend_count = bends;
+        song += 3;
+        break;
+      }
 
-            for(int index = 0; index<6; index++){
-              // putAnimationMouth(adivinawi,index);
-              bendTones(noteM, noteM+100, 1.04, 10, 10);    //1000 -> 400 
-              noteM-=100;
-            }
-        } 
- 
-        delay(300);
-        // putMouth(happyOpen);
-        putEyes(happyOpen);
-    break;
-
-
-    case PandoWave:
-        
-        // Reproduce the animation four times
-        for(int i = 0; i<2; i++){ 
-
-            int noteW = 500; 
-
-            for(int index = 0; index<10; index++){
-              // putAnimationMouth(wave,index);
-              bendTones(noteW, noteW+100, 1.02, 10, 10); 
-              noteW+=101;
-            }
-            for(int index = 0; index<10; index++){
-              // putAnimationMouth(wave,index);
-              bendTones(noteW, noteW+100, 1.02, 10, 10); 
-              noteW+=101;
-            }
-            for(int index = 0; index<10; index++){
-              // putAnimationMouth(wave,index);
-              bendTones(noteW, noteW-100, 1.02, 10, 10); 
-              noteW-=101;
-            }
-            for(int index = 0; index<10; index++){
-              // putAnimationMouth(wave,index);
-              bendTones(noteW, noteW-100, 1.02, 10, 10); 
-              noteW-=101;
-            }
-        }    
-
-        // clearMouth();
-        delay(100);
-        // putMouth(happyOpen);
-        putEyes(happyOpen);
-    break;
-
-    case PandoVictory:
-        
-        // putMouth(smallSurprise);
-        for (int i = 0; i < 60; ++i){
-          int pos[]={90,90,90+i,90-i};  
-          _moveServos(10,pos);
-          _tone(1600+i*20,15,1);
-        }
+      case OP_WAIT: {
+        unsigned int time = pgm_read_word(song);
+        unsigned long start = millis();
+        song += 2;
+        while (millis() - start < time) if (!_singTick(epoch)) return;
+        break;
+      }
 
-        // putMouth(bigSurprise);
-        for (int i = 0; i < 60; ++i){
-          int pos[]={90,90,150-i,30+i};  
-          _moveServos(10,pos);
-          _tone(2800+i*20,15,1);
-        }
+      case OP_SYNC:
+        if (pgm_read_byte(song++) & SYNC_SOUND)
+          while (sound_track != TRACK_IDLE) if (!_singTick(epoch)) return;
+        break;
 
-        // putMouth(happyOpen);
-        // SUPER HAPPY
-        //-----
-        tiptoeSwing(1,500,20);
-        sing(S_superHappy);
-        // putMouth(happyClosed);
-        tiptoeSwing(1,500,20); 
-        //-----
-
-        home();
-        // clearMouth();
-        // putMouth(happyOpen);
-        putEyes(happyOpen);
-
-    break;
-
-    case PandoFail:
-
-        // putMouth(sadOpen);
-        _moveServos(300,bendPos_1);
-        _tone(900,200,1);
-        // putMouth(sadClosed);
-        _moveServos(300,bendPos_2);
-        _tone(600,200,1);
-        // putMouth(confused);
-        _moveServos(300,bendPos_3);
-        _tone(300,200,1);
-        _moveServos(300,bendPos_4);
-        // putMouth(xMouth);
+      case OP_LOOP:
+        count = pgm_read_byte(song++);
+        loop = song;
+        break;
 
-        detachServos();
-        _tone(150,2200,1);
-        
-        delay(600);
-        // clearMouth();
-        // putMouth(happyOpen);
-        putEyes(happyOpen);
-        home();
-
-    break;
-
-    case PandoThinking:      // PandoFretful:
-        // putMouth(angry);
-        // putEyes(angry);
-        // normalEyes();
-
-        // bendTones(note_A5, note_D6, 1.02, 20, 4);
-        // bendTones(note_A5, note_E5, 1.02, 20, 4);
-        // delay(50);
-
-        normalEyes();
-        _moveServos(50, fretfulPos);   
-        home();
-        // delay(100);
-
-        normalEyesLeft();
-        _moveServos(50, fretfulPos);   
-        home();
-        // delay(100);
-
-        normalEyesUpLeft();
-        _moveServos(50, fretfulPos);   
-        home();
-        // delay(100);
-
-        normalEyesUp();
-        _moveServos(50, fretfulPos);   
-        home();
-        // delay(100);
-
-        normalEyesUpRight();
-        _moveServos(50, fretfulPos);   
-        home();
-        // delay(100);
-
-        normalEyesRight();
-        _moveServos(50, fretfulPos);   
-        home();
-        // delay(100);
-
-        // putMouth(angry);
-        // putEyes(angry);
-
-        // home();  
-        // putMouth(happyOpen);
-        // putEyes(happyOpen);
-    break;
+      case OP_NEXT:
+        if (loop != NULL && --count > 0) song = loop;
+        break;
 
+      default:          //-- OP_END, or not a sound: the song ends with its last note
+        while (sound_track != TRACK_IDLE) if (!_singTick(epoch)) return;
+        return;
+    }
   }
 }
 
+//-- A tick of sing(): the sound and the legs go on, the program of a
+//-- gesture waits. False once a request has been taken
+bool Pando::_singTick(uint8_t epoch){
 
-
-
-
-
+  _updateSound();
+  _updateServos();
+  _tick();
+  return preemptions == epoch;
+}
 
 
 
 ///////////////////////////////////////////////////////////////////
-//-- EYES ---------------------------------------------------//
+//-- GESTURES ---------------------------------------------------//
 ///////////////////////////////////////////////////////////////////
 
-// Print information on screen
-void Pando::print(const char str[], uint16_t speed) {
-  ht1632c.print(str, speed);
+//-- Poses of the gestures (POSE_*)
+const uint8_t gesture_poses[POSES][4] PROGMEM = {
+  {110, 70, 20, 160},   //-- POSE_SAD
+  {100, 80, 60, 120},   //-- POSE_BED
+  {90, 90, 145, 122},   //-- POSE_FART_1 (right bend)
+  {90, 90, 80, 122},    //-- POSE_FART_2
+  {90, 90, 145, 80},    //-- POSE_FART_3
+  {110, 70, 90, 90},    //-- POSE_CONFUSED
+  {90, 90, 70, 110},    //-- POSE_ANGRY
+  {110, 110, 90, 90},   //-- POSE_HEAD_LEFT
+  {70, 70, 90, 90},     //-- POSE_HEAD_RIGHT
+  {90, 90, 90, 110},    //-- POSE_FRETFUL
+  {90, 90, 70, 35},     //-- POSE_BEND_1
+  {90, 90, 55, 35},     //-- POSE_BEND_2
+  {90, 90, 42, 35},     //-- POSE_BEND_3
+  {90, 90, 34, 35},     //-- POSE_BEND_4
+  {90, 90, 150, 30},    //-- POSE_VICTORY
+  {90, 90, 90, 90}      //-- POSE_STAND
+};
+
+
+void Pando::playGesture(int gesture, uint8_t priority){
+
+  startGesture(gesture, priority);
+  while (_updateTimeline()) _tick();
 }
 
-void Pando::smileEyes() {
-  ht1632c.clearScreen();
-
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 4);
-
-  ht1632c.setPixel(5, 2);
-  ht1632c.setPixel(5, 3);
-
-  ht1632c.setPixel(6, 2);
-  ht1632c.setPixel(6, 3);
+//---------------------------------------------------------
+//-- Pando startGesture: start a gesture without waiting for it
+//--  update() must be called from loop() to play it
+//--  Parameters:
+//--    priority: requests with a higher one preempt it
+//---------------------------------------------------------
+void Pando::startGesture(int gesture, uint8_t priority){
 
-  ht1632c.setPixel(7, 3);
-  ht1632c.setPixel(7, 4);
+  if (gesture < 0 || gesture >= GESTURES) return;
 
-  ht1632c.setPixel(8, 4);
-  ht1632c.setPixel(8, 5);
+  startProgram((const uint8_t *)pgm_read_ptr(&gesture_code[gesture]), priority);
+  gesture_playing = gesture;
+}
 
-  ht1632c.setPixel(15, 4);
-  ht1632c.setPixel(15, 5);
+void Pando::playProgram(const uint8_t *code, uint8_t priority, uint8_t source){
 
-  ht1632c.setPixel(16, 3);
-  ht1632c.setPixel(16, 4);
+  startProgram(code, priority, source);
+  while (_updateTimeline()) _tick();
+}
 
-  ht1632c.setPixel(17, 2);
-  ht1632c.setPixel(17, 3);
+//-- Like startGesture(), for a program of the sketch. A PROGRAM_RAM program
+//-- must stay in place until it ends
+void Pando::startProgram(const uint8_t *code, uint8_t priority, uint8_t source){
 
-  ht1632c.setPixel(18, 2);
-  ht1632c.setPixel(18, 3);
+  //-- Whatever runs is replaced. The program waits for the legs to blend home
+  if (_runningPriority() != PRIORITY_IDLE) _cleanup();
 
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
+  eyes_before = eyes;
 
-  ht1632c.writeScreen();
+  program = code;
+  program_ram = source == PROGRAM_RAM;
+  program_priority = priority;
+  program_wait = millis();
+  program_sync = SYNC_SERVOS;
+  loop_depth = 0;
+  gesture_playing = -1;
 }
 
-void Pando::happyOpenEyes() {
-  ht1632c.clearScreen();
+//-- Stop the running gesture or motion and blend home
+void Pando::stopGesture(){
 
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 4);
-  ht1632c.setPixel(4, 5);
-  ht1632c.setPixel(4, 6);
-  ht1632c.setPixel(5, 2);
-  ht1632c.setPixel(6, 2);
-  ht1632c.setPixel(7, 2);
-  ht1632c.setPixel(8, 3);
-  ht1632c.setPixel(8, 4);
-  ht1632c.setPixel(8, 5);
-  ht1632c.setPixel(8, 6);
-
-  ht1632c.setPixel(15, 3);
-  ht1632c.setPixel(15, 4);
-  ht1632c.setPixel(15, 5);
-  ht1632c.setPixel(15, 6);
-  ht1632c.setPixel(16, 2);
-  ht1632c.setPixel(17, 2);
-  ht1632c.setPixel(18, 2);
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
-  ht1632c.setPixel(19, 5);
-  ht1632c.setPixel(19, 6);
-
-  ht1632c.writeScreen(); 
+  _cleanup();
+  while (_updateServos()) _background();
 }
 
-void Pando::angryEyes() {
-  ht1632c.clearScreen();
+//-- True while a gesture or a track is running
+bool Pando::isBusy(){
 
-  ht1632c.setPixel(4, 1);
-  ht1632c.setPixel(4, 2);
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 4);
-  ht1632c.setPixel(5, 2);
-  ht1632c.setPixel(5, 3);
-  ht1632c.setPixel(5, 4);
-  ht1632c.setPixel(5, 5);
-  ht1632c.setPixel(6, 3);
-  ht1632c.setPixel(6, 4);
-  ht1632c.setPixel(6, 5);
-  ht1632c.setPixel(6, 6);
-  ht1632c.setPixel(7, 4);
-  ht1632c.setPixel(7, 5);
-  ht1632c.setPixel(7, 6);
-  ht1632c.setPixel(8, 5);
-
-  ht1632c.setPixel(15, 5);
-  ht1632c.setPixel(16, 4);
-  ht1632c.setPixel(16, 5);
-  ht1632c.setPixel(16, 6);
-  ht1632c.setPixel(17, 3);
-  ht1632c.setPixel(17, 4);
-  ht1632c.setPixel(17, 5);
-  ht1632c.setPixel(17, 6);
-  ht1632c.setPixel(18, 2);
-  ht1632c.setPixel(18, 3);
-  ht1632c.setPixel(18, 4);
-  ht1632c.setPixel(18, 5);
-  ht1632c.setPixel(19, 1);
-  ht1632c.setPixel(19, 2);
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
-
-  ht1632c.writeScreen(); 
+  return program != NULL || servo_track != TRACK_IDLE || sound_track != TRACK_IDLE;
 }
 
-void Pando::sadEyes() {
-  ht1632c.clearScreen();
+//-- Operands of the gesture program, from PROGMEM or from RAM
+uint8_t Pando::_readByte(){
 
-  ht1632c.setPixel(3, 4);
-
-  ht1632c.setPixel(4, 5);
-
-  ht1632c.setPixel(5, 5);
-
-  ht1632c.setPixel(6, 5);
-
-  ht1632c.setPixel(7, 5);
-
-  ht1632c.setPixel(8, 4);
-
-  ht1632c.setPixel(15, 4);
-
-  ht1632c.setPixel(16, 5);
-
-  ht1632c.setPixel(17, 5);
-
-  ht1632c.setPixel(18, 5);
-
-  ht1632c.setPixel(19, 5);
-
-  ht1632c.setPixel(20, 4);
-
-  ht1632c.writeScreen(); 
+  return program_ram ? *program++ : pgm_read_byte(program++);
 }
 
-void Pando::sadOpenEyes() {
-  ht1632c.clearScreen();
-
-  ht1632c.setPixel(4, 4);
-  ht1632c.setPixel(4, 5);
-
-  ht1632c.setPixel(5, 3);
-  ht1632c.setPixel(5, 4);
-  ht1632c.setPixel(5, 5);
-  ht1632c.setPixel(5, 6);
-
-  ht1632c.setPixel(6, 3);
-  ht1632c.setPixel(6, 4);
-  ht1632c.setPixel(6, 5);
-  ht1632c.setPixel(6, 6);
-
-  ht1632c.setPixel(7, 2);
-  ht1632c.setPixel(7, 3);
-  ht1632c.setPixel(7, 4);
-  ht1632c.setPixel(7, 5);
-  ht1632c.setPixel(7, 6);
-
-  ht1632c.setPixel(8, 2);
-  ht1632c.setPixel(8, 3);
-  ht1632c.setPixel(8, 4);
-  ht1632c.setPixel(8, 5);
-
-  ht1632c.setPixel(9, 3);
+int Pando::_readWord(){
 
-  ht1632c.setPixel(15, 3);
-
-  ht1632c.setPixel(16, 2);
-  ht1632c.setPixel(16, 3);
-  ht1632c.setPixel(16, 4);
-  ht1632c.setPixel(16, 5);
-
-  ht1632c.setPixel(17, 2);
-  ht1632c.setPixel(17, 3);
-  ht1632c.setPixel(17, 4);
-  ht1632c.setPixel(17, 5);
-  ht1632c.setPixel(17, 6);
-
-  ht1632c.setPixel(18, 3);
-  ht1632c.setPixel(18, 4);
-  ht1632c.setPixel(18, 5);
-  ht1632c.setPixel(18, 6);
-
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
-  ht1632c.setPixel(19, 5);
-  ht1632c.setPixel(19, 6);
-
-  ht1632c.setPixel(20, 4);
-  ht1632c.setPixel(20, 5);
-
-  ht1632c.writeScreen(); 
+  uint8_t low = _readByte();
+  return (int16_t)(low | (_readByte() << 8));
 }
 
-void Pando::sadCloseEyes() {
-  ht1632c.clearScreen();
-
-  ht1632c.setPixel(5, 6);
-
-  ht1632c.setPixel(6, 5);
+//-- Run the gesture program until it has to wait for the time or for
+//-- a track. Returns false when the program is over
+bool Pando::_runProgram(){
 
-  ht1632c.setPixel(7, 4);
+  int target[4];
 
-  ht1632c.setPixel(8, 3);
+  while (program != NULL) {
 
-  ht1632c.setPixel(15, 3);
+    if ((long)(millis() - program_wait) < 0) return true;
+    if ((program_sync & SYNC_SERVOS) && servo_track != TRACK_IDLE) return true;
+    if ((program_sync & SYNC_SOUND) && sound_track != TRACK_IDLE) return true;
+    program_sync = 0;
 
-  ht1632c.setPixel(16, 4);
+    uint8_t op = _readByte();
+    switch (op) {
 
-  ht1632c.setPixel(17, 5);
-
-  ht1632c.setPixel(18, 6);
-
-  ht1632c.writeScreen(); 
-}
-
-void Pando::fartLeftEyes() {
-  ht1632c.clearScreen();
-
-  ht1632c.setPixel(3, 4);
-  ht1632c.setPixel(3, 5);
-
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 6);
-
-  ht1632c.setPixel(5, 3);
-  ht1632c.setPixel(5, 6);
+      case OP_END:
+        //-- The gesture ends with its last pose and sound
+        if (servo_track != TRACK_IDLE || sound_track != TRACK_IDLE) {
+          program--;
+          program_sync = SYNC_ALL;
+          return true;
+        }
+        program = NULL;
+        gesture_playing = -1;
+        return false;
+
+      case OP_POSE: {
+        uint8_t pose = _readByte();
+        int time = _readWord();
+        for (int i = 0; i < 4; i++) target[i] = pgm_read_byte(&gesture_poses[pose][i]);
+        motion = MOVE_POSE;
+        _startPose(time, target);
+        break;
+      }
 
-  ht1632c.setPixel(6, 3);
-  ht1632c.setPixel(6, 6);
+      case OP_HOME: {
+        int time = _readWord();
+        if (isPandoResting) break;
+        for (int i = 0; i < 4; i++) target[i] = 90;
+        motion = MOVE_HOME;
+        _startPose(time, target);
+        servo_home = true;
+        break;
+      }
 
-  ht1632c.setPixel(7, 3);
-  ht1632c.setPixel(7, 6);
+      case OP_GAIT: {
+        uint8_t gait = _readByte();
+        float steps = _readByte() / 10.0;
+        int T = _readWord();
+        int h = (int8_t)_readByte();
+        int dir = (int8_t)_readByte();
+        deferred = true;
+        _playGait(gait, steps, T, h, dir);
+        deferred = false;
+        break;
+      }
 
-  ht1632c.setPixel(8, 4);
-  ht1632c.setPixel(8, 5);
+      case OP_EYES:
+        putEyes(_readByte());
+        break;
 
-  ht1632c.setPixel(15, 4);
-  ht1632c.setPixel(15, 5);
+      case OP_TONE: {
+        int frequency = _readWord();
+        int duration = _readWord();
+        _startTone(frequency, duration, _readByte());
+        break;
+      }
 
-  ht1632c.setPixel(16, 3);
-  ht1632c.setPixel(16, 6);
+      case OP_BEND:
+      case OP_BENDS: {
+        bool run = op == OP_BENDS;
+        int first = _readWord();
+        int last = _readWord();    //-- The span for OP_BENDS
+        int step = run ? _readWord() : 0;
+        uint8_t count = run ? _readByte() : 1;
+        int prop = 1000 + _readByte();
+        uint8_t note = _readByte();
+        _startBend(first, run ? first + last : last, prop, note, _readByte());
+        bend_step = step;
+        bend_count = count;
+        break;
+      }
 
-  ht1632c.setPixel(17, 3);
-  ht1632c.setPixel(17, 6);
+      case OP_WAIT:
+        program_wait = millis() + _readWord();
+        break;
 
-  ht1632c.setPixel(18, 3);
-  ht1632c.setPixel(18, 6);
+      case OP_SYNC:
+        program_sync = _readByte();
+        break;
 
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 6);
+      case OP_LOOP: {
+        uint8_t count = _readByte();
+        if (loop_depth < LOOP_DEPTH) {
+          loop_start[loop_depth] = program;
+          loop_count[loop_depth++] = count;
+        }
+        break;
+      }
 
-  ht1632c.setPixel(20, 4);
-  ht1632c.setPixel(20, 5);
+      case OP_NEXT:
+        if (loop_depth == 0) break;
+        if (--loop_count[loop_depth-1] > 0) program = loop_start[loop_depth-1];
+        else loop_depth--;
+        break;
 
-  ht1632c.setPixel(4, 4);
-  ht1632c.setPixel(5, 4);
+      case OP_DETACH:
+        _stopServos();
+        detachServos();
+        break;
 
-  ht1632c.setPixel(16, 4);
-  ht1632c.setPixel(17, 4);
+      default:          //-- Not a gesture program: give up
+        program = NULL;
+        gesture_playing = -1;
+        return false;
+    }
+  }
 
-  ht1632c.writeScreen(); 
+  return false;
 }
 
-void Pando::fartRightEyes() {
-  ht1632c.clearScreen();
-
-  ht1632c.setPixel(3, 4);
-  ht1632c.setPixel(3, 5);
-
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 6);
+//-- Run the gesture program and advance the tracks
+//-- Returns false when everything is over
+bool Pando::_updateTimeline(){
 
-  ht1632c.setPixel(5, 3);
-  ht1632c.setPixel(5, 6);
+  bool running = _runProgram();
+  bool servos = _updateServos();
+  bool sound = _updateSound();
 
-  ht1632c.setPixel(6, 3);
-  ht1632c.setPixel(6, 6);
-
-  ht1632c.setPixel(7, 3);
-  ht1632c.setPixel(7, 6);
-
-  ht1632c.setPixel(8, 4);
-  ht1632c.setPixel(8, 5);
-
-  ht1632c.setPixel(15, 4);
-  ht1632c.setPixel(15, 5);
+  return running || servos || sound;
+}
 
-  ht1632c.setPixel(16, 3);
-  ht1632c.setPixel(16, 6);
 
-  ht1632c.setPixel(17, 3);
-  ht1632c.setPixel(17, 6);
 
-  ht1632c.setPixel(18, 3);
-  ht1632c.setPixel(18, 6);
+///////////////////////////////////////////////////////////////////
+//-- PREEMPTION -------------------------------------------------//
+///////////////////////////////////////////////////////////////////
 
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 6);
+//---------------------------------------------------------
+//-- Pando requestGesture: play a gesture at the next tick if its priority
+//--  is higher than the running one, else when Pando is idle (call update())
+//--  Safe to call from an interrupt. A pending request is only replaced
+//--  by one with the same or a higher priority
+//--  Returns false if the request was not taken
+//---------------------------------------------------------
+bool Pando::requestGesture(int gesture, uint8_t priority){
 
-  ht1632c.setPixel(20, 4);
-  ht1632c.setPixel(20, 5);
+  bool taken = false;
 
-  ht1632c.setPixel(6, 4);
-  ht1632c.setPixel(7, 4);
+  if (gesture < 0 || gesture >= GESTURES || priority == PRIORITY_IDLE) return false;
 
-  ht1632c.setPixel(18, 4);
-  ht1632c.setPixel(19, 4);
+#if defined(__AVR__)
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+#endif
+  {
+    if (request_gesture < 0 || priority >= request_priority) {
+      request_priority = priority;
+      request_time = millis();
+      request_gesture = gesture;
+      taken = true;
+    }
+  }
 
-  ht1632c.writeScreen(); 
+  return taken;
 }
 
-// check
-void Pando::bigEyes() {
-  ht1632c.clearScreen();
+void Pando::setMotionPriority(uint8_t priority){
 
-  ht1632c.setPixel(5, 2);
-  ht1632c.setPixel(5, 3);
-  ht1632c.setPixel(5, 4);
-  ht1632c.setPixel(5, 5);
-
-  ht1632c.setPixel(6, 1);
-  ht1632c.setPixel(6, 2);
-  ht1632c.setPixel(6, 3);
-  ht1632c.setPixel(6, 4);
-  ht1632c.setPixel(6, 5);
-  ht1632c.setPixel(6, 6);
-
-  ht1632c.setPixel(7, 1);
-  ht1632c.setPixel(7, 2);
-  ht1632c.setPixel(7, 3);
-  ht1632c.setPixel(7, 4);
-  ht1632c.setPixel(7, 5);
-  ht1632c.setPixel(7, 6);
-
-  ht1632c.setPixel(8, 2);
-  ht1632c.setPixel(8, 3);
-  ht1632c.setPixel(8, 4);
-  ht1632c.setPixel(8, 5);
-
-  ht1632c.setPixel(16, 2);
-  ht1632c.setPixel(16, 3);
-  ht1632c.setPixel(16, 4);
-  ht1632c.setPixel(16, 5);
-
-  ht1632c.setPixel(17, 1);
-  ht1632c.setPixel(17, 2);
-  ht1632c.setPixel(17, 3);
-  ht1632c.setPixel(17, 4);
-  ht1632c.setPixel(17, 5);
-  ht1632c.setPixel(17, 6);
-
-  ht1632c.setPixel(18, 1);
-  ht1632c.setPixel(18, 2);
-  ht1632c.setPixel(18, 3);
-  ht1632c.setPixel(18, 4);
-  ht1632c.setPixel(18, 5);
-  ht1632c.setPixel(18, 6);
-
-  ht1632c.setPixel(19, 2);
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
-  ht1632c.setPixel(19, 5);
-
-  ht1632c.writeScreen(); 
+  motion_priority = priority;
 }
 
-void Pando::closeEyes() {
-  ht1632c.clearScreen();
+uint8_t Pando::getPriority(){
 
-  ht1632c.setPixel(4, 5);
-  ht1632c.setPixel(5, 5);
-  ht1632c.setPixel(6, 5);  
-  ht1632c.setPixel(7, 5);
-  ht1632c.setPixel(8, 5);
+  return _runningPriority();
+}
 
-  ht1632c.setPixel(16, 5);
-  ht1632c.setPixel(17, 5);
-  ht1632c.setPixel(18, 5);
-  ht1632c.setPixel(19, 5);
-  ht1632c.setPixel(20, 5);
+//-- The hook runs at every tick, even inside blocking motions: it can poll
+//-- the sensors and call requestGesture(), but it must not move Pando
+void Pando::attachTickHook(void (*hook)()){
 
-  ht1632c.writeScreen(); 
+  tick_hook = hook;
 }
 
-void Pando::surpriseEyes() {
-  ht1632c.clearScreen();
+//-- Time from the last request taken to its preemption (ms)
+unsigned int Pando::getPreemptLatency(){
 
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 4);
-  ht1632c.setPixel(4, 5);
-  ht1632c.setPixel(5, 2);  
-  ht1632c.setPixel(5, 6);
-  ht1632c.setPixel(6, 2);
-  ht1632c.setPixel(6, 4);
-  ht1632c.setPixel(6, 6);
-  ht1632c.setPixel(7, 2);  
-  ht1632c.setPixel(7, 6);  
-  ht1632c.setPixel(8, 3);
-  ht1632c.setPixel(8, 4);
-  ht1632c.setPixel(8, 5);
-
-  ht1632c.setPixel(15, 3);
-  ht1632c.setPixel(15, 4);
-  ht1632c.setPixel(15, 5);
-  ht1632c.setPixel(16, 2);  
-  ht1632c.setPixel(16, 6);
-  ht1632c.setPixel(17, 2);
-  ht1632c.setPixel(17, 4);
-  ht1632c.setPixel(17, 6);
-  ht1632c.setPixel(18, 2);  
-  ht1632c.setPixel(18, 6);
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
-  ht1632c.setPixel(19, 5);
-
-  ht1632c.writeScreen();   
+  return preempt_latency;
 }
 
-void Pando::confusedEyes() {
-  ht1632c.clearScreen();
-
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 4);
-  ht1632c.setPixel(4, 5);
-  ht1632c.setPixel(5, 2);  
-  ht1632c.setPixel(5, 6);
-  ht1632c.setPixel(6, 2);
-  ht1632c.setPixel(6, 6);
-  ht1632c.setPixel(7, 2);  
-  ht1632c.setPixel(7, 6);  
-  ht1632c.setPixel(8, 3);
-  ht1632c.setPixel(8, 4);
-  ht1632c.setPixel(8, 5);
-
-  ht1632c.setPixel(15, 3);
-  ht1632c.setPixel(15, 4);
-  ht1632c.setPixel(15, 5);
-  ht1632c.setPixel(16, 2);  
-  ht1632c.setPixel(16, 6);
-  ht1632c.setPixel(17, 2);
-  ht1632c.setPixel(17, 6);
-  ht1632c.setPixel(18, 2);  
-  ht1632c.setPixel(18, 6);
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
-  ht1632c.setPixel(19, 5);
-
-  ht1632c.writeScreen();   
-}
-
-// check
-void Pando::normalEyes() {
-  ht1632c.clearScreen();
+unsigned int Pando::getPreemptLatencyMax(){
 
-  // left eye
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 4);
-  ht1632c.setPixel(4, 5);
+  return preempt_latency_max;
+}
 
-  ht1632c.setPixel(5, 2);  
-  ht1632c.setPixel(5, 6);
+uint8_t Pando::_runningPriority(){
 
-  ht1632c.setPixel(6, 2);
-  ht1632c.setPixel(6, 6);
+  if (program != NULL) return program_priority;
+  if (servo_track != TRACK_IDLE || sound_track != TRACK_IDLE || waiting) return motion_priority;
+  return PRIORITY_IDLE;
+}
 
-  ht1632c.setPixel(7, 2);  
-  ht1632c.setPixel(7, 6);
+//-- Cleanup of a preempted gesture or motion: silence, the eyes it found
+//-- and the legs blending home (the servos stay on for what comes next)
+void Pando::_cleanup(){
 
-  ht1632c.setPixel(8, 2);
-  ht1632c.setPixel(8, 6);
+  _stopServos();
 
-  ht1632c.setPixel(9, 3);
-  ht1632c.setPixel(9, 4);
-  ht1632c.setPixel(9, 5);
+  if (sound_track != TRACK_IDLE) {
+    noTone(pinBuzzer);
+    sound_track = TRACK_IDLE;
+  }
 
-  // right eye
-  ht1632c.setPixel(14, 3);
-  ht1632c.setPixel(14, 4);
-  ht1632c.setPixel(14, 5);
+  if (program != NULL && eyes_before >= 0) putEyes(eyes_before);
+  program = NULL;
+  gesture_playing = -1;
 
-  ht1632c.setPixel(15, 2);  
-  ht1632c.setPixel(15, 6);
+  if (isPandoResting) return;
 
-  ht1632c.setPixel(16, 2);
-  ht1632c.setPixel(16, 6);
+  int homes[4] = {90, 90, 90, 90};
+  for (int i = 0; i < 4; i++) {
+    if (servo_position[i] != homes[i]) {
+      motion = MOVE_HOME;
+      _startPose(PREEMPT_BLEND, homes);
+      break;
+    }
+  }
+}
 
-  ht1632c.setPixel(17, 2);  
-  ht1632c.setPixel(17, 6);
+//-- Load the pending request if it beats the running priority
+bool Pando::_takeRequest(){
 
-  ht1632c.setPixel(18, 2);
-  ht1632c.setPixel(18, 6);
+  uint8_t running = _runningPriority();
+  int8_t gesture;
+  uint8_t priority;
+  unsigned long time;
 
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
-  ht1632c.setPixel(19, 5);
+  noInterrupts();
+  gesture = request_gesture;
+  priority = request_priority;
+  time = request_time;
+  bool take = gesture >= 0 && priority > running;
+  if (take) request_gesture = -1;
+  interrupts();
 
-  // left eyeball
-  ht1632c.setPixel(6, 4);
-  ht1632c.setPixel(6, 5);
-  ht1632c.setPixel(7, 4);
-  ht1632c.setPixel(7, 5);
+  if (!take) return false;
 
-  // right eyeball
-  ht1632c.setPixel(16, 4);
-  ht1632c.setPixel(16, 5);
-  ht1632c.setPixel(17, 4);
-  ht1632c.setPixel(17, 5);
+  preempt_latency = millis() - time;
+  if (preempt_latency > preempt_latency_max) preempt_latency_max = preempt_latency;
+  preemptions++;
 
-  ht1632c.writeScreen();
+  startGesture(gesture, priority);
+  return true;
 }
 
-// check
-void Pando::normalEyesLeft() {
-  ht1632c.clearScreen();
-
-  // left eye
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 4);
-  ht1632c.setPixel(4, 5);
 
-  ht1632c.setPixel(5, 2);  
-  ht1632c.setPixel(5, 6);
 
-  ht1632c.setPixel(6, 2);
-  ht1632c.setPixel(6, 6);
 
-  ht1632c.setPixel(7, 2);  
-  ht1632c.setPixel(7, 6);
 
-  ht1632c.setPixel(8, 2);
-  ht1632c.setPixel(8, 6);
 
-  ht1632c.setPixel(9, 3);
-  ht1632c.setPixel(9, 4);
-  ht1632c.setPixel(9, 5);
 
-  // right eye
-  ht1632c.setPixel(14, 3);
-  ht1632c.setPixel(14, 4);
-  ht1632c.setPixel(14, 5);
 
-  ht1632c.setPixel(15, 2);  
-  ht1632c.setPixel(15, 6);
 
-  ht1632c.setPixel(16, 2);
-  ht1632c.setPixel(16, 6);
-
-  ht1632c.setPixel(17, 2);  
-  ht1632c.setPixel(17, 6);
+#ifdef PANDO_WATCHDOG
+///////////////////////////////////////////////////////////////////
+//-- MOTION WATCHDOG --------------------------------------------//
+///////////////////////////////////////////////////////////////////
 
-  ht1632c.setPixel(18, 2);
-  ht1632c.setPixel(18, 6);
+Pando *Pando::watched = NULL;
 
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
-  ht1632c.setPixel(19, 5);
+//-- Runs in the watchdog interrupt: the motion tick has stalled
+void Pando::_watchdogExpired(){
 
-  // left eyeball
-  ht1632c.setPixel(5, 4);
-  ht1632c.setPixel(5, 5);
-  ht1632c.setPixel(6, 4);
-  ht1632c.setPixel(6, 5);
+  if (watched == NULL) return;
 
-  // right eyeball
-  ht1632c.setPixel(15, 4);
-  ht1632c.setPixel(15, 5);
-  ht1632c.setPixel(16, 4);
-  ht1632c.setPixel(16, 5);
+  watched->watchdog_event.time = millis();
+  watched->watchdog_event.motion = watched->motion;
+  watched->watchdog_event.gesture = watched->gesture_playing;
+  watched->watchdog_event.count++;
 
-  ht1632c.writeScreen();
+  //-- Stop the pulses: the servos release their torque
+  watched->detachServos();
 }
 
-// check
-void Pando::normalEyesRight() {
-  ht1632c.clearScreen();
+WatchdogEvent Pando::getWatchdogEvent(){
 
-  // left eye
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 4);
-  ht1632c.setPixel(4, 5);
+  noInterrupts();
+  WatchdogEvent event = watchdog_event;
+  interrupts();
 
-  ht1632c.setPixel(5, 2);  
-  ht1632c.setPixel(5, 6);
+  return event;
+}
+#endif
 
-  ht1632c.setPixel(6, 2);
-  ht1632c.setPixel(6, 6);
 
-  ht1632c.setPixel(7, 2);  
-  ht1632c.setPixel(7, 6);
 
-  ht1632c.setPixel(8, 2);
-  ht1632c.setPixel(8, 6);
 
-  ht1632c.setPixel(9, 3);
-  ht1632c.setPixel(9, 4);
-  ht1632c.setPixel(9, 5);
+#ifdef PANDO_PROFILER
+///////////////////////////////////////////////////////////////////
+//-- MOTION PROFILER --------------------------------------------//
+///////////////////////////////////////////////////////////////////
 
-  // right eye
-  ht1632c.setPixel(14, 3);
-  ht1632c.setPixel(14, 4);
-  ht1632c.setPixel(14, 5);
+//---------------------------------------------------------
+//-- Pando dumpProfile: print planned vs actual timing of the last moves
+//---------------------------------------------------------
+void Pando::dumpProfile(Print &out){
 
-  ht1632c.setPixel(15, 2);  
-  ht1632c.setPixel(15, 6);
+  profiler.dump(out);
+}
 
-  ht1632c.setPixel(16, 2);
-  ht1632c.setPixel(16, 6);
+void Pando::clearProfile(){
 
-  ht1632c.setPixel(17, 2);  
-  ht1632c.setPixel(17, 6);
+  profiler.clear();
+}
+#endif
 
-  ht1632c.setPixel(18, 2);
-  ht1632c.setPixel(18, 6);
 
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
-  ht1632c.setPixel(19, 5);
 
-  // left eyeball
-  ht1632c.setPixel(7, 4);
-  ht1632c.setPixel(7, 5);
-  ht1632c.setPixel(8, 4);
-  ht1632c.setPixel(8, 5);
 
-  // right eyeball
-  ht1632c.setPixel(17, 4);
-  ht1632c.setPixel(17, 5);
-  ht1632c.setPixel(18, 4);
-  ht1632c.setPixel(18, 5);
+///////////////////////////////////////////////////////////////////
+//-- EYES ---------------------------------------------------//
+///////////////////////////////////////////////////////////////////
 
-  ht1632c.writeScreen();
+// Print information on screen
+void Pando::print(const char str[], uint16_t speed) {
+  eye_animation = NULL;
+  tweening = false;
+  _dropBlink();
+  eyes = EYES_NONE;
+  ht1632c.print(str, speed);
 }
 
-// check
-void Pando::normalEyesUp() {
-  ht1632c.clearScreen();
+void Pando::smileEyes() {
+  putEyes(smile);
+}
 
-  // left eye
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 4);
-  ht1632c.setPixel(4, 5);
+void Pando::happyOpenEyes() {
+  putEyes(happyOpen);
+}
 
-  ht1632c.setPixel(5, 2);  
-  ht1632c.setPixel(5, 6);
+void Pando::angryEyes() {
+  putEyes(angry);
+}
 
-  ht1632c.setPixel(6, 2);
-  ht1632c.setPixel(6, 6);
+void Pando::sadEyes() {
+  putEyes(sad);
+}
 
-  ht1632c.setPixel(7, 2);  
-  ht1632c.setPixel(7, 6);
+void Pando::sadOpenEyes() {
+  putEyes(sadOpen);
+}
 
-  ht1632c.setPixel(8, 2);
-  ht1632c.setPixel(8, 6);
+void Pando::sadCloseEyes() {
+  putEyes(sadClosed);
+}
 
-  ht1632c.setPixel(9, 3);
-  ht1632c.setPixel(9, 4);
-  ht1632c.setPixel(9, 5);
+void Pando::fartLeftEyes() {
+  putEyes(fartLeft);
+}
 
-  // right eye
-  ht1632c.setPixel(14, 3);
-  ht1632c.setPixel(14, 4);
-  ht1632c.setPixel(14, 5);
+void Pando::fartRightEyes() {
+  putEyes(fartRight);
+}
 
-  ht1632c.setPixel(15, 2);  
-  ht1632c.setPixel(15, 6);
+void Pando::bigEyes() {
+  putEyes(bigRound);
+}
 
-  ht1632c.setPixel(16, 2);
-  ht1632c.setPixel(16, 6);
+void Pando::closeEyes() {
+  putEyes(happyClosed);
+}
 
-  ht1632c.setPixel(17, 2);  
-  ht1632c.setPixel(17, 6);
+void Pando::surpriseEyes() {
+  putEyes(surprised);
+}
 
-  ht1632c.setPixel(18, 2);
-  ht1632c.setPixel(18, 6);
+void Pando::confusedEyes() {
+  putEyes(confused);
+}
 
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
-  ht1632c.setPixel(19, 5);
+void Pando::normalEyes() {
+  putEyes(normal);
+}
 
-  // left eyeball
-  ht1632c.setPixel(6, 3);
-  ht1632c.setPixel(6, 4);
-  ht1632c.setPixel(7, 3);
-  ht1632c.setPixel(7, 4);
+void Pando::normalEyesLeft() {
+  putEyes(normalLeft);
+}
 
-  // right eyeball
-  ht1632c.setPixel(16, 3);
-  ht1632c.setPixel(16, 4);
-  ht1632c.setPixel(17, 3);
-  ht1632c.setPixel(17, 4);
+void Pando::normalEyesRight() {
+  putEyes(normalRight);
+}
 
-  ht1632c.writeScreen();
+void Pando::normalEyesUp() {
+  putEyes(normalUp);
 }
 
-// check
 void Pando::normalEyesUpLeft() {
-  ht1632c.clearScreen();
-
-  // left eye
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 4);
-  ht1632c.setPixel(4, 5);
-
-  ht1632c.setPixel(5, 2);  
-  ht1632c.setPixel(5, 6);
-
-  ht1632c.setPixel(6, 2);
-  ht1632c.setPixel(6, 6);
-
-  ht1632c.setPixel(7, 2);  
-  ht1632c.setPixel(7, 6);
-
-  ht1632c.setPixel(8, 2);
-  ht1632c.setPixel(8, 6);
-
-  ht1632c.setPixel(9, 3);
-  ht1632c.setPixel(9, 4);
-  ht1632c.setPixel(9, 5);
-
-  // right eye
-  ht1632c.setPixel(14, 3);
-  ht1632c.setPixel(14, 4);
-  ht1632c.setPixel(14, 5);
-
-  ht1632c.setPixel(15, 2);  
-  ht1632c.setPixel(15, 6);
-
-  ht1632c.setPixel(16, 2);
-  ht1632c.setPixel(16, 6);
-
-  ht1632c.setPixel(17, 2);  
-  ht1632c.setPixel(17, 6);
-
-  ht1632c.setPixel(18, 2);
-  ht1632c.setPixel(18, 6);
-
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
-  ht1632c.setPixel(19, 5);
-
-  // left eyeball
-  ht1632c.setPixel(5, 3);
-  ht1632c.setPixel(5, 4);
-  ht1632c.setPixel(6, 3);
-  ht1632c.setPixel(6, 4);
-
-  // right eyeball
-  ht1632c.setPixel(15, 3);
-  ht1632c.setPixel(15, 4);
-  ht1632c.setPixel(16, 3);
-  ht1632c.setPixel(16, 4);
-
-  ht1632c.writeScreen();
+  putEyes(normalUpLeft);
 }
 
-// check
 void Pando::normalEyesUpRight() {
-  ht1632c.clearScreen();
-
-  // left eye
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 4);
-  ht1632c.setPixel(4, 5);
-
-  ht1632c.setPixel(5, 2);  
-  ht1632c.setPixel(5, 6);
-
-  ht1632c.setPixel(6, 2);
-  ht1632c.setPixel(6, 6);
-
-  ht1632c.setPixel(7, 2);  
-  ht1632c.setPixel(7, 6);
-
-  ht1632c.setPixel(8, 2);
-  ht1632c.setPixel(8, 6);
-
-  ht1632c.setPixel(9, 3);
-  ht1632c.setPixel(9, 4);
-  ht1632c.setPixel(9, 5);
-
-  // right eye
-  ht1632c.setPixel(14, 3);
-  ht1632c.setPixel(14, 4);
-  ht1632c.setPixel(14, 5);
-
-  ht1632c.setPixel(15, 2);  
-  ht1632c.setPixel(15, 6);
-
-  ht1632c.setPixel(16, 2);
-  ht1632c.setPixel(16, 6);
+  putEyes(normalUpRight);
+}
 
-  ht1632c.setPixel(17, 2);  
-  ht1632c.setPixel(17, 6);
+void Pando::smallLoveEyes() {
+  putEyes(smallHeart);
+}
 
-  ht1632c.setPixel(18, 2);
-  ht1632c.setPixel(18, 6);
+void Pando::loveEyes() {
+  putEyes(heart);
+}
 
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
-  ht1632c.setPixel(19, 5);
 
-  // left eyeball
-  ht1632c.setPixel(7, 3);
-  ht1632c.setPixel(7, 4);
-  ht1632c.setPixel(8, 3);
-  ht1632c.setPixel(8, 4);
 
-  // right eyeball
-  ht1632c.setPixel(17, 3);
-  ht1632c.setPixel(17, 4);
-  ht1632c.setPixel(18, 3);
-  ht1632c.setPixel(18, 4);
+///////////////////////////////////////////////////////////////////
+//-- Eyes Animation --------------------------------------------------//
+///////////////////////////////////////////////////////////////////
 
-  ht1632c.writeScreen();
+//---------------------------------------------------------
+//-- Pando playEyes: start an eye animation (ANIM_*) and return
+//--  Parameters:
+//--    mode: PLAY_ONCE, PLAY_LOOP or PLAY_PINGPONG (PLAY_DEFAULT: the
+//--    mode of the animation)
+//---------------------------------------------------------
+void Pando::playEyes(int animation, uint8_t mode) {
+  const uint8_t *frames = eyeAnimation(animation);
+  if (frames == NULL) return;
+
+  uint8_t format = pgm_read_byte(frames);
+
+  eye_animation = frames;
+  tweening = false;
+  _dropBlink();
+  eye_data = format & EYE_CLIP ? frames + 2 : NULL;
+  eye_mode = mode == PLAY_DEFAULT ? format & ~EYE_CLIP : mode;
+  if (eye_data != NULL && eye_mode == PLAY_PINGPONG) eye_mode = PLAY_LOOP;
+  eye_frames = pgm_read_byte(frames + 1);
+  eye_step = 1;
+  _showEyeFrame(0);
 }
 
-void Pando::smallLoveEyes() {
-  ht1632c.clearScreen();
-
-  // left eye
-  ht1632c.setPixel(4, 3);
-
-  ht1632c.setPixel(5, 2);
-  ht1632c.setPixel(5, 3);
-  ht1632c.setPixel(5, 4);
-
-  ht1632c.setPixel(6, 3);
-  ht1632c.setPixel(6, 4);
-  ht1632c.setPixel(6, 5);
+void Pando::stopEyes() {
+  eye_animation = NULL;
+  tweening = false;
+}
 
-  ht1632c.setPixel(7, 2);
-  ht1632c.setPixel(7, 3);
-  ht1632c.setPixel(7, 4);
+bool Pando::isEyesPlaying() {
+  return eye_animation != NULL;
+}
 
-  ht1632c.setPixel(8, 3);
+void Pando::_showEyeFrame(int8_t frame) {
+  eye_frame = frame;
+
+  //-- Clips are decoded straight into the display buffer
+  if (eye_data != NULL) {
+    uint32_t changed;
+    if (frame == 0) eye_data = eye_animation + 2;
+    eye_next = millis() + 10UL * pgm_read_byte(eye_data);
+    eye_data = decodeEyeFrame(eye_data + 1, ht1632c.getBuffer(), changed);
+    eyes = -1;
+    _flushEyes();
+    return;
+  }
 
-  // right eye
-  ht1632c.setPixel(15, 3);
+  const uint8_t *step = eye_animation + 2 + 2 * frame;
+  eye_next = millis() + 10UL * pgm_read_byte(step + 1);
+  _drawEyes(pgm_read_byte(step));
+}
 
-  ht1632c.setPixel(16, 2);
-  ht1632c.setPixel(16, 3);
-  ht1632c.setPixel(16, 4);
+//-- Called at every tick
+void Pando::_updateEyes() {
+  if (tweening && (long)(millis() - tween_next) >= 0) _tweenEyes();
+  if (auto_blink && eye_animation == NULL && !tweening) _autoBlink();
+  if (eye_animation == NULL || (long)(millis() - eye_next) < 0) return;
+
+  int8_t next = eye_frame + eye_step;
+  if (next < 0 || next >= eye_frames) {
+    switch (eye_mode) {
+      case PLAY_LOOP:
+        next = 0;
+        break;
+      case PLAY_PINGPONG:
+        eye_step = -eye_step;
+        next = eye_frames > 1 ? eye_frame + eye_step : 0;
+        break;
+      default:
+        eye_animation = NULL;
+        return;
+    }
+  }
 
-  ht1632c.setPixel(17, 3);
-  ht1632c.setPixel(17, 4);
-  ht1632c.setPixel(17, 5);
+  _showEyeFrame(next);
+}
 
-  ht1632c.setPixel(18, 2);
-  ht1632c.setPixel(18, 3);
-  ht1632c.setPixel(18, 4);
+//---------------------------------------------------------
+//-- Pando tweenEyes: go from the eyes on the display to an expression
+//--  Parameters:
+//--    time: length of the transition (ms), 0 changes at once
+//---------------------------------------------------------
+void Pando::tweenEyes(int eyeExpression, unsigned int time) {
+  if (time == 0) {
+    putEyes(eyeExpression);
+    return;
+  }
 
-  ht1632c.setPixel(19, 3);
+  _endBlink();
+  if (!eyeFrame(eyeExpression, eye_saved)) return;
 
-  ht1632c.writeScreen();
+  eye_animation = NULL;
+  tweening = true;
+  tween_expression = eyeExpression;
+  tween_step = 0;
+  tween_period = time / TWEEN_STEPS;
+  tween_next = millis();
+  _tweenEyes();
 }
 
-void Pando::loveEyes() {
-  ht1632c.clearScreen();
+//-- One in-between frame. The mask only grows, so the pixels it does not
+//-- cover still show the eyes the transition started from
+void Pando::_tweenEyes() {
+  uint8_t *matrix = ht1632c.getBuffer();
 
-  // left eye
-  ht1632c.setPixel(3, 2);
-  ht1632c.setPixel(3, 3);
-
-  ht1632c.setPixel(4, 1);
-  ht1632c.setPixel(4, 2);
-  ht1632c.setPixel(4, 3);
-  ht1632c.setPixel(4, 4);
+  tween_step++;
+  for (uint8_t c = 0; c < EYE_FRAME_SIZE; c++) {
+    uint8_t mask = dissolveMask(c, tween_step);
+    matrix[c] = (matrix[c] & ~mask) | (eye_saved[c] & mask);
+  }
+  _flushEyes();
 
-  ht1632c.setPixel(5, 1);
-  ht1632c.setPixel(5, 2);
-  ht1632c.setPixel(5, 3);
-  ht1632c.setPixel(5, 4);
-  ht1632c.setPixel(5, 5);
+  if (tween_step >= TWEEN_STEPS) {
+    eyes = tween_expression;
+    tweening = false;
+  }
+  else tween_next += tween_period;
+}
 
-  ht1632c.setPixel(6, 2);
-  ht1632c.setPixel(6, 3);
-  ht1632c.setPixel(6, 4);
-  ht1632c.setPixel(6, 5);
-  ht1632c.setPixel(6, 6);
+//-- Send what changed in the display buffer (see DFRobot_HT1632C::flush)
+void Pando::_flushEyes() {
+  uint16_t bits = ht1632c.flush();
+  if (bits == 0) return;
 
-  ht1632c.setPixel(7, 1);
-  ht1632c.setPixel(7, 2);
-  ht1632c.setPixel(7, 3);
-  ht1632c.setPixel(7, 4);
-  ht1632c.setPixel(7, 5);
+  display_stats.updates++;
+  display_stats.bits += bits;
+}
 
-  ht1632c.setPixel(8, 1);
-  ht1632c.setPixel(8, 2);
-  ht1632c.setPixel(8, 3);
-  ht1632c.setPixel(8, 4);
+//-- Put a frame on the display, sending what changed
+void Pando::_changeEyes(const uint8_t *frame) {
+  memcpy(ht1632c.getBuffer(), frame, EYE_FRAME_SIZE);
+  _flushEyes();
+}
 
-  ht1632c.setPixel(9, 2);
-  ht1632c.setPixel(9, 3);
+///////////////////////////////////////////////////////////////////
+//-- Auto-blink -------------------------------------------------//
+///////////////////////////////////////////////////////////////////
 
-  // right eye
-  ht1632c.setPixel(14, 2);
-  ht1632c.setPixel(14, 3);
+//---------------------------------------------------------
+//-- Pando setAutoBlink: blink now and then, on its own
+//--  Parameters:
+//--    interval: mean time between blinks (ms)
+//---------------------------------------------------------
+void Pando::setAutoBlink(bool state, unsigned int interval) {
+  if (!state) _endBlink();
 
-  ht1632c.setPixel(15, 1);
-  ht1632c.setPixel(15, 2);
-  ht1632c.setPixel(15, 3);
-  ht1632c.setPixel(15, 4);
+  auto_blink = state;
+  blink_interval = interval;
+  blink_next = millis() + random(interval / 2, interval * 3UL / 2);
+}
 
-  ht1632c.setPixel(16, 1);
-  ht1632c.setPixel(16, 2);
-  ht1632c.setPixel(16, 3);
-  ht1632c.setPixel(16, 4);
-  ht1632c.setPixel(16, 5);
+//-- Called at every tick, when no eye animation nor transition runs
+void Pando::_autoBlink() {
+  if ((long)(millis() - blink_next) < 0) return;
 
-  ht1632c.setPixel(17, 2);
-  ht1632c.setPixel(17, 3);
-  ht1632c.setPixel(17, 4);
-  ht1632c.setPixel(17, 5);
-  ht1632c.setPixel(17, 6);
+  if (blinking) {
+    _endBlink();
+    return;
+  }
 
-  ht1632c.setPixel(18, 1);
-  ht1632c.setPixel(18, 2);
-  ht1632c.setPixel(18, 3);
-  ht1632c.setPixel(18, 4);
-  ht1632c.setPixel(18, 5);
+  //-- Gestures choose their own eyes, closed eyes and text do not blink
+  if (program != NULL || eyes == happyClosed || eyes == sadClosed || eyes == EYES_NONE) {
+    blink_next = millis() + BLINK_TIME_MAX;
+    return;
+  }
 
-  ht1632c.setPixel(19, 1);
-  ht1632c.setPixel(19, 2);
-  ht1632c.setPixel(19, 3);
-  ht1632c.setPixel(19, 4);
+  uint8_t closed[EYE_FRAME_SIZE];
+  eyeFrame(happyClosed, closed);
+  memcpy(eye_saved, ht1632c.getBuffer(), EYE_FRAME_SIZE);
+  _changeEyes(closed);
+  display_stats.blinks++;
+  blinking = true;
+  blink_next = millis() + random(BLINK_TIME_MIN, BLINK_TIME_MAX + 1);
+}
 
-  ht1632c.setPixel(20, 2);
-  ht1632c.setPixel(20, 3);
+//-- Open the eyes again, as they were before the blink
+void Pando::_endBlink() {
+  if (!blinking) return;
 
-  ht1632c.writeScreen();
+  _changeEyes(eye_saved);
+  _dropBlink();
 }
 
+//-- Other eyes replace the closed ones: the blink is over without them,
+//-- and the next one comes after a whole interval
+void Pando::_dropBlink() {
+  if (!blinking) return;
 
+  blinking = false;
+  blink_next = millis() + random(blink_interval / 2, blink_interval * 3UL / 2);
+}
 
-///////////////////////////////////////////////////////////////////
-//-- Eyes Animation --------------------------------------------------//
-///////////////////////////////////////////////////////////////////
+void Pando::clearDisplayStats() {
+  display_stats.updates = 0;
+  display_stats.bits = 0;
+  display_stats.blinks = 0;
+}
 
 void Pando::blinkEyes() {
-  happyOpenEyes();
-  delay(400);
-  closeEyes();
-  delay(100);
+  playEyes(ANIM_BLINK);
 }
 
 void Pando::binkLoveEyes() {
-  smallLoveEyes();
-  delay(500);
-  loveEyes();
-  delay(500);
+  playEyes(ANIM_LOVE);
 }
 
 void Pando::gazeAround() {
-  normalEyes();
-  delay(100);
-  normalEyesLeft();
-  delay(100);
-  normalEyesUpLeft();
-  delay(100);
-  normalEyesUp();
-  delay(100);
-  normalEyesUpRight();
-  delay(100);
-  normalEyesRight();
-  delay(100);
+  playEyes(ANIM_GAZE);
+}
+
+
+//---------------------------------------------------------
+//-- Pando drawEyes: render the eyes from parameters (see renderEyes).
+//-- The display is only written when the eyes change, so it is cheap
+//-- to call at every loop()
+//---------------------------------------------------------
+void Pando::drawEyes(const EyeParams &eye) {
+  eye_animation = NULL;
+  tweening = false;
+  eyes = -1;
+  if (!blinking) {
+    renderEyes(ht1632c.getBuffer(), eye);
+    _flushEyes();
+    return;
+  }
+
+  //-- During a blink the same eyes again do not open them: the blink
+  //-- ends on its own. Other eyes drop it
+  uint8_t frame[EYE_FRAME_SIZE];
+  renderEyes(frame, eye);
+  if (memcmp(frame, eye_saved, EYE_FRAME_SIZE) == 0) return;
+  _dropBlink();
+  _changeEyes(frame);
 }
 
+void Pando::drawEyes(int8_t pupil_x, int8_t pupil_y, uint8_t lid_top, uint8_t lid_bottom, uint8_t shape) {
+  EyeParams eye = {pupil_x, pupil_y, lid_top, lid_bottom, shape};
+  drawEyes(eye);
+}
 
+//---------------------------------------------------------
+//-- Pando lookAt: turn the pupils to a direction
+//--  Parameters:
+//--    angle: degrees, left > 0 (a sound direction, a heading...)
+//--    elevation: degrees, up > 0
+//---------------------------------------------------------
+void Pando::lookAt(int angle, int elevation) {
+  //-- Rounded to the nearest pixel
+  int x = (angle >= 0 ? angle + GAZE_STEP / 2 : angle - GAZE_STEP / 2) / GAZE_STEP;
+  int y = (elevation >= 0 ? elevation + GAZE_STEP / 2 : elevation - GAZE_STEP / 2) / GAZE_STEP;
+  drawEyes(-constrain(x, -8, 8), -constrain(y, -8, 8));
+}
@@ -1,169 +1,420 @@
-#ifndef Pando_h
-#define Pando_h
-
-#include <Servo.h>
-#include <Oscillator.h>
-#include <EEPROM.h>
-
-// #include <US.h>
-// #include "MaxMatrix.h"
-#include "DFRobot_HT1632C.h"
-#include <BatReader.h>
-
-// #include "Pando_mouths.h"
-#include "Pando_eyes.h"
-#include "Pando_sounds.h"
-#include "Pando_gestures.h"
-
-
-//-- Constants
-#define FORWARD     1
-#define BACKWARD    -1
-#define LEFT        1
-#define RIGHT       -1
-#define SMALL       5
-#define MEDIUM      15
-#define BIG         30
-
-#define PIN_Buzzer  13
-// #define PIN_Trigger 8
-// #define PIN_Echo    9
-#define PIN_NoiseSensor A3
-
-
-class Pando
-{
-  public:
-
-    //-- Pando initialization
-    void init(int YL, int YR, int RL, int RR, bool load_calibration=true, int NoiseSensor=PIN_NoiseSensor, int Buzzer=PIN_Buzzer/*, int USTrigger=PIN_Trigger, int USEcho=PIN_Echo*/);
-
-    //-- Attach & detach functions
-    void attachServos();
-    void detachServos();
-
-    //-- Oscillator Trims
-    void setTrims(int YL, int YR, int RL, int RR);
-    void saveTrimsOnEEPROM();
-
-    //-- Predetermined Motion Functions
-    void _moveServos(int time, int  servo_target[]);
-    void oscillateServos(int A[4], int O[4], int T, double phase_diff[4], float cycle);
-
-    //-- HOME = Pando at rest position
-    void home();
-    bool getRestState();
-    void setRestState(bool state);
-    
-    //-- Predetermined Motion Functions
-    void jump(float steps=1, int T = 2000);
-
-    void walk(float steps=4, int T=1000, int dir = FORWARD);
-    void turn(float steps=4, int T=2000, int dir = LEFT);
-    void bend (int steps=1, int T=1400, int dir=LEFT);
-    void shakeLeg (int steps=1, int T = 2000, int dir=RIGHT);
-
-    void updown(float steps=1, int T=1000, int h = 20);
-    void swing(float steps=1, int T=1000, int h=20);
-    void tiptoeSwing(float steps=1, int T=900, int h=20);
-    void jitter(float steps=1, int T=500, int h=20);
-    void ascendingTurn(float steps=1, int T=900, int h=20);
-
-    void moonwalker(float steps=1, int T=900, int h=20, int dir=LEFT);
-    void crusaito(float steps=1, int T=900, int h=20, int dir=FORWARD);
-    void flapping(float steps=1, int T=1000, int h=20, int dir=FORWARD);
-
-    //-- Sensors functions
-    // float getDistance(); //US sensor
-    int getNoise();      //Noise Sensor
-
-    //-- Battery
-    double getBatteryLevel();
-    double getBatteryVoltage();
-    
-    //-- Mouth & Animations
-    // void putMouth(unsigned long int mouth, bool predefined = true);
-    // void putAnimationMouth(unsigned long int anim, int index);
-    // void clearMouth();
-
-    //-- Eye & Animations
-    void print(const char str[], uint16_t speed);
-
-    
-    void putEyes(int eyeExpression);
-
-    void smileEyes();
-    void happyOpenEyes();
-    void angryEyes();
-
-    void sadEyes();
-    void sadOpenEyes();
-    void sadCloseEyes();
-
-    void fartLeftEyes();
-    void fartRightEyes();
-
-    void bigEyes();
-    void closeEyes();
-    void surpriseEyes();
-    void confusedEyes();
-    void normalEyes();
-    void normalEyesLeft();
-    void normalEyesRight();
-    void normalEyesUp();
-    void normalEyesUpLeft();
-    void normalEyesUpRight();
-    void smallLoveEyes();
-    void loveEyes();
-
-    void blinkEyes();
-    void binkLoveEyes();
-    void gazeAround();
-
-
-
-
-
-
-
-
-    //-- Sounds
-    void _tone (float noteFrequency, long noteDuration, int silentDuration);
-    void bendTones (float initFrequency, float finalFrequency, float prop, long noteDuration, int silentDuration);
-    void sing(int songName);
-
-    //-- Gestures
-    void playGesture(int gesture);
-
-  private:
-    
-    // MaxMatrix ledmatrix=MaxMatrix(12,10,11, 1);
-    // DFRobot_HT1632C ht1632c = DFRobot_HT1632C(DATA, WR, CS);
-    DFRobot_HT1632C ht1632c = DFRobot_HT1632C(11, 10, 12);
-
-    BatReader battery;
-    Oscillator servo[4];
-    // US us;
-
-    int servo_pins[4];
-    int servo_trim[4];
-    int servo_position[4];
-
-    int pinBuzzer;
-    int pinNoiseSensor;
-    
-    unsigned long final_time;
-    unsigned long partial_time;
-    float increment[4];
-
-    bool isPandoResting;
-
-    // unsigned long int getMouthShape(int number);
-    // unsigned long int getAnimShape(int anim, int index);
-    void _execute(int A[4], int O[4], int T, double phase_diff[4], float steps);
-
-};
-
-#endif
-
-
+#ifndef Pando_h
+#define Pando_h
+
+#include <Servo.h>
+#include <Oscillator.h>
+#include <EEPROM.h>
+
+// #include <US.h>
+// #include "MaxMatrix.h"
+#include "DFRobot_HT1632C.h"
+#include <BatReader.h>
+#include <Gyro.h>
+
+// #include "Pando_mouths.h"
+#include "Pando_eyes.h"
+#include "Pando_sounds.h"
+#include "Pando_gestures.h"
+#include "Pando_gaits.h"
+#include "Pando_timeline.h"
+#include "Pando_odometry.h"
+#include "Pando_config.h"
+#include "Pando_profiler.h"
+#include "Pando_watchdog.h"
+
+
+//-- Constants
+#define FORWARD     1
+#define BACKWARD    -1
+#define LEFT        1
+#define RIGHT       -1
+#define SMALL       5
+#define MEDIUM      15
+#define BIG         30
+
+#define PIN_Buzzer  13
+// #define PIN_Trigger 8
+// #define PIN_Echo    9
+#define PIN_NoiseSensor A3
+
+//-- Heading hold (see Pando::holdHeading)
+#define GYRO_PERIOD             20    //-- Gyro update period while moving (ms)
+#define HEADING_KP              0.5   //-- Hip amplitude (degrees) per degree of heading error
+                                      //-- (negative if the gyro yaw grows turning right)
+#define HEADING_KI              0.05  //-- Same, per accumulated degree of error
+#define HEADING_INTEGRAL_MAX    100   //-- Anti windup (accumulated degrees)
+#define HEADING_MAX_CORRECTION  12    //-- Max hip amplitude change (degrees)
+
+//-- Slope compensation (see Pando::setSlopeCompensation)
+//-- Pitch is the gyro X angle (nose up > 0), roll the Y angle (left side up > 0)
+#define SLOPE_FILTER            0.5   //-- Weight of a new measure in the slope estimate
+#define SLOPE_THRESHOLD         2     //-- Slope change (degrees) that recomputes the biases
+#define SLOPE_ROLL_GAIN         0.5   //-- Foot lean (degrees) per degree of roll
+#define SLOPE_PITCH_GAIN        0.3   //-- Extra tiptoe (degrees) per degree of pitch
+#define SLOPE_MAX_BIAS          10    //-- Max offset bias (degrees)
+
+
+class Pando
+{
+  public:
+
+    Pando() {gyro=NULL; heading_hold=false; slope_compensation=false; resetHeadingError();
+             servo_track=TRACK_IDLE; sound_track=TRACK_IDLE; deferred=false; program=NULL;
+             request_gesture=-1; motion_priority=PRIORITY_NORMAL; tick_hook=NULL; eye_animation=NULL; tweening=false;
+             auto_blink=false; blinking=false; clearDisplayStats();};
+
+    //-- Pando initialization
+    void init(int YL, int YR, int RL, int RR, bool load_calibration=true, int NoiseSensor=PIN_NoiseSensor, int Buzzer=PIN_Buzzer/*, int USTrigger=PIN_Trigger, int USEcho=PIN_Echo*/);
+
+    //-- Attach & detach functions
+    void attachServos();
+    void detachServos();
+
+    //-- Plays the gesture started with startGesture() and does the
+    //-- background work (gyro, watchdog...). Call it from loop().
+    //-- Returns true while the gesture goes on
+    bool update();
+
+    //-- Oscillator Trims
+    void setTrims(int YL, int YR, int RL, int RR);
+    void saveTrimsOnEEPROM();
+
+    //-- Predetermined Motion Functions
+    void _moveServos(int time, int  servo_target[]);
+    void oscillateServos(int A[4], int O[4], int T, double phase_diff[4], float cycle);
+
+    //-- HOME = Pando at rest position
+    void home();
+    bool getRestState();
+    void setRestState(bool state);
+    
+    //-- Predetermined Motion Functions
+    void jump(float steps=1, int T = 2000);
+
+    void walk(float steps=4, int T=1000, int dir = FORWARD);
+    void turn(float steps=4, int T=2000, int dir = LEFT);
+    void bend (int steps=1, int T=1400, int dir=LEFT);
+    void shakeLeg (int steps=1, int T = 2000, int dir=RIGHT);
+
+    void updown(float steps=1, int T=1000, int h = 20);
+    void swing(float steps=1, int T=1000, int h=20);
+    void tiptoeSwing(float steps=1, int T=900, int h=20);
+    void jitter(float steps=1, int T=500, int h=20);
+    void ascendingTurn(float steps=1, int T=900, int h=20);
+
+    void moonwalker(float steps=1, int T=900, int h=20, int dir=LEFT);
+    void crusaito(float steps=1, int T=900, int h=20, int dir=FORWARD);
+    void flapping(float steps=1, int T=1000, int h=20, int dir=FORWARD);
+
+    //-- Sensors functions
+    // float getDistance(); //US sensor
+    int getNoise();      //Noise Sensor
+    void attachGyro(Gyro &gyro_sensor);
+
+    //-- Heading hold: walk() steers to keep the gyro yaw on a heading
+    void holdHeading(double heading);
+    void holdCurrentHeading();
+    void releaseHeading();
+    double getHeadingError();
+    double getHeadingErrorMax();
+    void resetHeadingError();
+
+    //-- Odometry: pose estimated from the gait cycles (mm, degrees)
+    void resetPose(double x=0, double y=0, double heading=0);
+    double getPoseX();
+    double getPoseY();
+    double getPoseHeading();
+    double getDistanceTo(double x, double y);
+    double getBearingTo(double x, double y);
+    double getDistanceTravelled();
+    float getGaitCycles(int gait);
+    void calibrateGait(int gait, int forward, int lateral, int turn);
+
+    //-- Slope compensation: gait offsets biased by the ground inclination
+    void setSlopeCompensation(bool state);
+    void measureSlope();
+    double getSlopePitch();
+    double getSlopeRoll();
+
+    //-- Battery
+    double getBatteryLevel();
+    double getBatteryVoltage();
+    
+    //-- Mouth & Animations
+    // void putMouth(unsigned long int mouth, bool predefined = true);
+    // void putAnimationMouth(unsigned long int anim, int index);
+    // void clearMouth();
+
+    //-- Eye & Animations
+    void print(const char str[], uint16_t speed);
+
+    
+    void putEyes(int eyeExpression);
+
+    void smileEyes();
+    void happyOpenEyes();
+    void angryEyes();
+
+    void sadEyes();
+    void sadOpenEyes();
+    void sadCloseEyes();
+
+    void fartLeftEyes();
+    void fartRightEyes();
+
+    void bigEyes();
+    void closeEyes();
+    void surpriseEyes();
+    void confusedEyes();
+    void normalEyes();
+    void normalEyesLeft();
+    void normalEyesRight();
+    void normalEyesUp();
+    void normalEyesUpLeft();
+    void normalEyesUpRight();
+    void smallLoveEyes();
+    void loveEyes();
+
+    //-- Eye animations: they return at once and go on at every tick,
+    //-- also while Pando walks. putEyes() stops them
+    void playEyes(int animation, uint8_t mode=PLAY_DEFAULT);
+    void stopEyes();
+    bool isEyesPlaying();
+
+    void blinkEyes();
+    void binkLoveEyes();
+    void gazeAround();
+
+    //-- Procedural eyes: any pupil position and lid opening, so the gaze
+    //-- can follow a direction. They stop the eye animations too
+    void drawEyes(const EyeParams &eye);
+    void drawEyes(int8_t pupil_x, int8_t pupil_y, uint8_t lid_top=0, uint8_t lid_bottom=0, uint8_t shape=SHAPE_ROUND);
+    void lookAt(int angle, int elevation=0);
+
+    //-- Change the expression through in-between frames. It returns at once,
+    //-- the transition goes on at every tick. putEyes() stops it
+    void tweenEyes(int eyeExpression, unsigned int time=TWEEN_TIME);
+
+    //-- Blink now and then, in the background. The eyes on the display come
+    //-- back after the blink. There are no blinks while a gesture plays, nor
+    //-- while an eye animation or a transition runs
+    void setAutoBlink(bool state, unsigned int interval=BLINK_INTERVAL);
+
+    const DisplayStats &getDisplayStats() {return display_stats;};
+    void clearDisplayStats();
+
+
+
+
+
+
+
+
+    //-- Sounds
+    void _tone (float noteFrequency, long noteDuration, int silentDuration);
+    void bendTones (float initFrequency, float finalFrequency, float prop, long noteDuration, int silentDuration);
+    void sing(int songName);
+
+    //-- Gestures
+    void playGesture(int gesture, uint8_t priority=PRIORITY_NORMAL);
+    void startGesture(int gesture, uint8_t priority=PRIORITY_NORMAL);   //-- Returns at once, update() plays it
+    void stopGesture();
+    bool isBusy();
+
+    //-- Gesture programs in PROGMEM or in RAM (see Pando_timeline.h)
+    void playProgram(const uint8_t *code, uint8_t priority=PRIORITY_NORMAL, uint8_t source=PROGRAM_FLASH);
+    void startProgram(const uint8_t *code, uint8_t priority=PRIORITY_NORMAL, uint8_t source=PROGRAM_FLASH);
+
+    //-- Preemption: the gesture plays at the next tick if its priority is
+    //-- higher than the one running. Safe to call from an interrupt
+    bool requestGesture(int gesture, uint8_t priority=PRIORITY_HIGH);
+    void setMotionPriority(uint8_t priority);   //-- Priority of walk(), bend()...
+    uint8_t getPriority();                      //-- Of what runs now (PRIORITY_IDLE if nothing)
+    void attachTickHook(void (*hook)());        //-- Called at every tick (sensor polling)
+    unsigned int getPreemptLatency();           //-- Request to preemption (ms)
+    unsigned int getPreemptLatencyMax();
+
+#ifdef PANDO_PROFILER
+    //-- Motion profiler
+    void dumpProfile(Print &out = Serial);
+    void clearProfile();
+#endif
+
+#ifdef PANDO_WATCHDOG
+    //-- Motion watchdog: last trip (count is 0 if it never tripped).
+    //-- Only there when PANDO_WATCHDOG is set in Pando_config.h or as a
+    //-- build flag: a #define in the sketch does not reach the library
+    WatchdogEvent getWatchdogEvent();
+#endif
+
+  private:
+    
+    // MaxMatrix ledmatrix=MaxMatrix(12,10,11, 1);
+    // DFRobot_HT1632C ht1632c = DFRobot_HT1632C(DATA, WR, CS);
+    DFRobot_HT1632C_Fast<11, 10, 12> ht1632c;
+
+    BatReader battery;
+    Oscillator servo[4];
+    // US us;
+
+    int servo_pins[4];
+    int servo_trim[4];
+    int servo_position[4];
+
+    int pinBuzzer;
+    int pinNoiseSensor;
+    
+    bool isPandoResting;
+
+    uint8_t motion;           //-- GAIT_* / MOVE_* being done
+    int8_t gesture_playing;   //-- -1 when no gesture is being played
+
+    Gyro *gyro;
+    unsigned long gyro_time;
+
+    bool heading_hold;
+    double heading_target;
+    double heading_integral;
+    double heading_error_sum;
+    double heading_error_max;
+    unsigned int heading_cycles;
+
+    Odometry odometry;
+
+    bool slope_compensation;
+    double slope_pitch, slope_roll;       //-- Filtered inclination (degrees)
+    double slope_pitch_used, slope_roll_used;   //-- Inclination of the cached biases
+    int slope_bias[4];                    //-- Offset biases for the next gaits
+
+    //-- Servo track (see Pando_timeline.h)
+    uint8_t servo_track;          //-- TRACK_IDLE / TRACK_POSE / TRACK_GAIT
+    bool servo_home;              //-- Detach the servos when the pose ends
+    bool deferred;                //-- _execute() loads the track and returns
+    unsigned long servo_start;    //-- Start of the pose or of the gait cycle
+    unsigned long servo_sample;   //-- Last pose sample
+    unsigned int pose_time;
+    int pose_from[4];
+    int pose_to[4];
+    int gait_A[4];
+    int gait_O[4];
+    int gait_hips[2];             //-- Hip amplitudes before any steering
+    double gait_phase[4];
+    int gait_T;
+    float gait_steps;
+    float gait_part;              //-- Part of a period run by this cycle
+    int gait_cycle;
+    int8_t gait_dir;
+
+    //-- Sound track
+    uint8_t sound_track;          //-- TRACK_IDLE / TRACK_TONE / TRACK_BEND
+    unsigned long sound_next;     //-- End of the current note and its silence
+    bool bend_up;
+    int bend_freq;
+    int bend_first;               //-- Initial frequency of the current bend
+    int bend_final;
+    int bend_prop;                //-- prop*1000
+    int bend_note;
+    int bend_silence;
+    int bend_step;                //-- OP_BENDS: next bend = this one + step
+    uint8_t bend_count;           //-- Bends left, this one included
+
+    //-- Gesture program
+    const uint8_t *program;           //-- Next opcode, NULL when no gesture is running
+    bool program_ram;                 //-- The program is not in PROGMEM
+    unsigned long program_wait;       //-- End of OP_WAIT
+    uint8_t program_sync;             //-- Tracks OP_SYNC waits for
+    const uint8_t *loop_start[LOOP_DEPTH];
+    uint8_t loop_count[LOOP_DEPTH];
+    uint8_t loop_depth;
+    uint8_t program_priority;
+
+    //-- Preemption
+    volatile int8_t request_gesture;          //-- -1 when there is no request
+    volatile uint8_t request_priority;
+    volatile unsigned long request_time;
+    uint8_t motion_priority;
+    uint8_t preemptions;                      //-- Blocking motions give up when it changes
+    bool waiting;                             //-- In _wait()
+    int8_t eyes;                              //-- Last putEyes() expression, EYES_NONE for text
+    int8_t eyes_before;                       //-- Eyes before the running gesture
+    unsigned int preempt_latency;
+    unsigned int preempt_latency_max;
+    void (*tick_hook)();
+
+    //-- Eye animation
+    const uint8_t *eye_animation;     //-- PROGMEM, NULL when none plays
+    uint8_t eye_mode;
+    uint8_t eye_frames;
+    int8_t eye_frame;
+    int8_t eye_step;                  //-- 1 or -1 (PLAY_PINGPONG)
+    unsigned long eye_next;           //-- End of the current frame
+    const uint8_t *eye_data;          //-- Next frame of a clip, NULL for expressions
+
+    //-- Eye tweening
+    bool tweening;
+    int8_t tween_expression;
+    uint8_t eye_saved[EYE_FRAME_SIZE];  //-- End of the transition, or the eyes under a blink
+    uint8_t tween_step;
+    unsigned int tween_period;
+    unsigned long tween_next;
+
+    //-- Auto-blink
+    bool auto_blink;
+    bool blinking;                    //-- The eyes are closed
+    unsigned int blink_interval;
+    unsigned long blink_next;         //-- Time of the next blink, or of its end
+
+    DisplayStats display_stats;
+
+#ifdef PANDO_PROFILER
+    Profiler profiler;
+#endif
+
+#ifdef PANDO_WATCHDOG
+    WatchdogEvent watchdog_event;
+    static Pando *watched;
+    static void _watchdogExpired();
+#endif
+
+    // unsigned long int getMouthShape(int number);
+    // unsigned long int getAnimShape(int anim, int index);
+    void _execute(int A[4], int O[4], int T, double phase_diff[4], float steps, int gait=GAIT_NONE, int dir=0);
+    void _steer(int A[4], const int hips[2], int dir);
+    void _countCycles(int gait, int dir, float cycles);
+    void _updateSlopeBias();
+    void _tick();
+    void _wait(unsigned long time);
+
+    void _startPose(int time, int servo_target[4]);
+    void _startCycle();
+    bool _updateServos();
+    void _stopServos();
+    void _setServoTrack(uint8_t track);
+    void _playGait(int gait, float steps, int T, int h, int dir);
+    void _startTone(int frequency, int duration, int silence);
+    void _startBend(int initFrequency, int finalFrequency, int prop, int noteDuration, int silence);
+    bool _updateSound();
+    bool _singTick(uint8_t epoch);
+    bool _runProgram();
+    uint8_t _readByte();
+    int _readWord();
+    bool _updateTimeline();
+    uint8_t _runningPriority();
+    void _cleanup();
+    bool _takeRequest();
+    void _background();
+    void _drawEyes(int eyeExpression);
+    void _showEyeFrame(int8_t frame);
+    void _updateEyes();
+    void _tweenEyes();
+    void _flushEyes();
+    void _changeEyes(const uint8_t *frame);
+    void _autoBlink();
+    void _endBlink();
+    void _dropBlink();
+
+};
+
+#endif
+
+
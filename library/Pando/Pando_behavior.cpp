@@ -0,0 +1,212 @@
+//--------------------------------------------------------------
+//-- Pando behavior
+//-- Sensor samples -> events -> emotions -> gestures, with
+//-- hysteresis on the sensors, decay of the emotions and a
+//-- cooldown per behavior
+//--------------------------------------------------------------
+#include "Pando_behavior.h"
+
+#if defined(ARDUINO)
+  #include <Arduino.h>
+#else
+  //-- Host build (tools/behavior_replay.cpp)
+  #include <string.h>
+  #define PROGMEM
+  #define pgm_read_byte(address) (*(const uint8_t *)(address))
+  #define memcpy_P memcpy
+#endif
+
+//-- Effect of every event on the emotions (x2)
+static const int8_t event_effects[EVENTS][EMOTIONS] PROGMEM = {
+  //-- JOY  AFFECTION  FEAR  ANGER  BOREDOM
+  {    15,     35,     -20,     0,  -128 },   //-- EVENT_TOUCH
+  {    10,     45,     -40,   -20,  -128 },   //-- EVENT_HOLD
+  {    45,      0,      10,     0,  -128 },   //-- EVENT_NOISE
+  {   -30,      0,     100,     0,  -128 },   //-- EVENT_TILT
+  {    25,      0,     -30,     0,  -128 }    //-- EVENT_UPRIGHT
+};
+
+//-- Fading of every emotion: level/256 lost per period (0: it does not fade)
+static const uint8_t emotion_decay[EMOTIONS] PROGMEM = {
+  3,      //-- JOY: half of it is gone in ~3 s
+  2,      //-- AFFECTION: ~4.5 s
+  8,      //-- FEAR: ~1 s
+  2,      //-- ANGER: ~4.5 s
+  0       //-- BOREDOM: only events clear it
+};
+
+//-- The behaviors. When several can play, the one with the emotion
+//-- furthest over its threshold wins
+struct BehaviorRule {
+  uint8_t emotion;
+  uint8_t threshold;
+  uint8_t gesture;
+  uint8_t priority;
+  uint8_t cooldown;     //-- Seconds
+  uint8_t relief;       //-- The emotion drops this much when it plays
+};
+
+static const BehaviorRule behaviors[BEHAVIORS] PROGMEM = {
+  { EMOTION_FEAR,      150, PandoSad,        PRIORITY_URGENT,  3, 120 },
+  { EMOTION_ANGER,     150, PandoAngry,      PRIORITY_HIGH,   10, 120 },
+  { EMOTION_AFFECTION, 120, PandoLove,       PRIORITY_HIGH,    5, 100 },
+  { EMOTION_JOY,       160, PandoSuperHappy, PRIORITY_NORMAL,  8, 120 },
+  { EMOTION_JOY,        80, PandoHappy,      PRIORITY_LOW,    15,  60 },
+  { EMOTION_BOREDOM,   200, PandoSleeping,   PRIORITY_LOW,    60, 200 },
+  { EMOTION_BOREDOM,   100, PandoThinking,   PRIORITY_LOW,    30,   0 }
+};
+
+//-- Add to an emotion, saturating at 0 and 255
+static void feel(uint8_t &emotion, int amount){
+
+  int level = emotion + amount;
+  emotion = level < 0 ? 0 : (level > 255 ? 255 : level);
+}
+
+
+Behavior::Behavior(){
+
+  _disabled = 0;
+  reset();
+}
+
+void Behavior::reset(){
+
+  for (int i = 0; i < EMOTIONS; i++) _emotion[i] = 0;
+  for (int i = 0; i < BEHAVIORS; i++) _cooldown[i] = 0;
+
+  _events = 0;
+  _last_events = 0;
+  _tick = 0;
+  _last_event = 0;
+  _touch_start = 0;
+  _last_touch = 0;
+  _quiet_ticks = 0;
+  _touch = _held = _noisy = _tilted = false;
+  _priority = PRIORITY_IDLE;
+  _behavior = -1;
+}
+
+void Behavior::setEnabled(int behavior, bool state){
+
+  if (behavior < 0 || behavior >= BEHAVIORS) return;
+
+  if (state) _disabled &= ~(1 << behavior);
+  else _disabled |= 1 << behavior;
+}
+
+int8_t Behavior::update(const SensorSample &sample, unsigned long now, uint8_t running){
+
+  _events |= _sense(sample, now);
+
+  if (now - _tick < BEHAVIOR_PERIOD) return -1;
+
+  //-- A loop() that was busy for a while gets the decay of all the periods
+  //-- it missed, but a single decision
+  unsigned long periods = (now - _tick) / BEHAVIOR_PERIOD;
+  if (_tick == 0 || periods > 100) periods = 1;
+  _tick = now;
+
+  for (unsigned long i = 0; i < periods; i++) _feel(i == 0 ? _events : 0, now);
+  _last_events = _events;
+  _events = 0;
+
+  return _choose(now, running);
+}
+
+//-- Turn the samples into events (hysteresis and edges)
+uint8_t Behavior::_sense(const SensorSample &sample, unsigned long now){
+
+  uint8_t events = 0;
+
+  if (sample.touch && !_touch) {
+    events |= EVENT_TOUCH;
+    //-- Poking too fast annoys Pando
+    if (now - _last_touch < TOUCH_SPAM) feel(_emotion[EMOTION_ANGER], 70);
+    _last_touch = now;
+    _touch_start = now;
+  }
+  if (sample.touch && !_held && now - _touch_start >= HOLD_TIME) {
+    events |= EVENT_HOLD;
+    _held = true;
+  }
+  if (!sample.touch) _held = false;
+  _touch = sample.touch;
+
+  if (!_noisy && sample.noise > NOISE_ON) {
+    events |= EVENT_NOISE;
+    _noisy = true;
+  }
+  else if (_noisy && sample.noise < NOISE_OFF) _noisy = false;
+
+  float pitch = sample.pitch < 0 ? -sample.pitch : sample.pitch;
+  float roll = sample.roll < 0 ? -sample.roll : sample.roll;
+  float tilt = pitch > roll ? pitch : roll;
+  if (!_tilted && tilt > TILT_ON && tilt < TILT_MAX) {
+    events |= EVENT_TILT;
+    _tilted = true;
+  }
+  else if (_tilted && tilt < TILT_OFF) {
+    events |= EVENT_UPRIGHT;
+    _tilted = false;
+  }
+
+  return events;
+}
+
+//-- One period of the emotions: the events, then the fading
+void Behavior::_feel(uint8_t events, unsigned long now){
+
+  for (int e = 0; e < EVENTS; e++) {
+    if (!(events & (1 << e))) continue;
+    for (int i = 0; i < EMOTIONS; i++)
+      feel(_emotion[i], 2 * (int8_t)pgm_read_byte(&event_effects[e][i]));
+  }
+
+  for (int i = 0; i < EMOTIONS; i++) {
+    uint8_t decay = pgm_read_byte(&emotion_decay[i]);
+    if (decay > 0 && _emotion[i] > 0) feel(_emotion[i], -(((int)_emotion[i] * decay + 255) >> 8));
+  }
+
+  //-- Nothing happening for a while is boring
+  if (events) {
+    _last_event = now;
+    _quiet_ticks = 0;
+  }
+  else if (now - _last_event >= QUIET_TIME && ++_quiet_ticks >= BOREDOM_TICKS) {
+    feel(_emotion[EMOTION_BOREDOM], 1);
+    _quiet_ticks = 0;
+  }
+}
+
+//-- The behavior to play now, if any can beat what is running
+int8_t Behavior::_choose(unsigned long now, uint8_t running){
+
+  BehaviorRule rule, chosen;
+  int best = -1;
+  int margin = -1;
+
+  for (int i = 0; i < BEHAVIORS; i++) {
+    memcpy_P(&rule, &behaviors[i], sizeof(rule));
+
+    if (_disabled & (1 << i)) continue;
+    if (rule.priority <= running) continue;
+    if ((long)(now - _cooldown[i]) < 0) continue;
+    if (_emotion[rule.emotion] < rule.threshold) continue;
+
+    if (_emotion[rule.emotion] - rule.threshold > margin) {
+      margin = _emotion[rule.emotion] - rule.threshold;
+      best = i;
+      chosen = rule;
+    }
+  }
+
+  if (best < 0) return -1;
+
+  feel(_emotion[chosen.emotion], -chosen.relief);
+  _cooldown[best] = now + 1000UL * chosen.cooldown;
+  _priority = chosen.priority;
+  _behavior = best;
+
+  return chosen.gesture;
+}
@@ -0,0 +1,104 @@
+#ifndef Pando_behavior_h
+#define Pando_behavior_h
+
+#include <stdint.h>
+#include "Pando_gestures.h"
+
+//***********************************************************************************
+//*********************************BEHAVIOR******************************************
+//***********************************************************************************
+//-- Emotion state machine: the sensor samples become events, the events feed
+//-- emotions that fade with time, and an emotion above the threshold of a
+//-- behavior picks its gesture. Behaviors have a cooldown, so a sensor that
+//-- stays on does not replay the same gesture over and over.
+//-- It does not know about Pando or the Arduino (the time is a parameter),
+//-- so tools/behavior_replay.cpp runs it on recorded sensor traces
+
+#define BEHAVIOR_PERIOD     50    //-- Emotion update and decision period (ms)
+
+//-- Sensor hysteresis: an event fires when the value goes over ON and
+//-- can only fire again after it went back under OFF
+#define NOISE_ON            30
+#define NOISE_OFF           15
+#define TILT_ON             50    //-- Degrees of pitch or roll
+#define TILT_OFF            30
+#define TILT_MAX            80    //-- Over this, the gyro reading is not trusted
+#define HOLD_TIME           1500  //-- Touch held this long (ms) is a hold
+#define TOUCH_SPAM          600   //-- Touches closer than this (ms) annoy Pando
+#define QUIET_TIME          10000 //-- Time without events before boredom grows (ms)
+#define BOREDOM_TICKS       4     //-- Periods per boredom point once quiet
+
+//-- Events (bit mask)
+#define EVENT_TOUCH         0x01
+#define EVENT_HOLD          0x02
+#define EVENT_NOISE         0x04
+#define EVENT_TILT          0x08
+#define EVENT_UPRIGHT       0x10  //-- Back up after a tilt
+#define EVENTS              5
+
+//-- Emotions (levels 0 to 255)
+#define EMOTION_JOY         0
+#define EMOTION_AFFECTION   1
+#define EMOTION_FEAR        2
+#define EMOTION_ANGER       3
+#define EMOTION_BOREDOM     4
+#define EMOTIONS            5
+
+#define BEHAVIORS           7
+
+
+//-- What the sketch reads from the sensors
+struct SensorSample {
+  bool touch;
+  int noise;
+  float pitch;        //-- Gyro X angle (degrees)
+  float roll;         //-- Gyro Y angle (degrees)
+};
+
+class Behavior
+{
+  public:
+    Behavior();
+
+    void reset();
+
+    //---------------------------------------------------------
+    //-- Feed a sample. It is cheap to call at every loop(): the emotions
+    //-- and the decision only run every BEHAVIOR_PERIOD ms
+    //--  Parameters:
+    //--    now: millis()
+    //--    running: priority of what Pando is doing (Pando::getPriority)
+    //--  Returns the gesture to request (with getPriority()), -1 if none
+    //---------------------------------------------------------
+    int8_t update(const SensorSample &sample, unsigned long now, uint8_t running);
+
+    uint8_t getPriority() {return _priority;};      //-- Of the last gesture returned
+    int8_t getBehavior() {return _behavior;};        //-- Index of the last behavior chosen
+    uint8_t getEmotion(int emotion) {return emotion >= 0 && emotion < EMOTIONS ? _emotion[emotion] : 0;};
+    uint8_t getEvents() {return _last_events;};     //-- Events of the last period
+
+    void setEnabled(int behavior, bool state);
+
+  private:
+    uint8_t _sense(const SensorSample &sample, unsigned long now);
+    void _feel(uint8_t events, unsigned long now);
+    int8_t _choose(unsigned long now, uint8_t running);
+
+    uint8_t _emotion[EMOTIONS];
+    unsigned long _cooldown[BEHAVIORS];   //-- Time when each behavior can play again
+    uint8_t _disabled;                    //-- Bit mask of behaviors
+
+    uint8_t _events;                      //-- Since the last period
+    uint8_t _last_events;
+    unsigned long _tick;                  //-- Last period
+    unsigned long _last_event;
+    unsigned long _touch_start;
+    unsigned long _last_touch;
+    uint8_t _quiet_ticks;
+
+    bool _touch, _held, _noisy, _tilted;  //-- Hysteresis state
+    uint8_t _priority;
+    int8_t _behavior;
+};
+
+#endif
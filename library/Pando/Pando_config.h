@@ -0,0 +1,33 @@
+#ifndef Pando_config_h
+#define Pando_config_h
+
+//***********************************************************************************
+//*********************************BUILD OPTIONS*************************************
+//***********************************************************************************
+//-- These switches change the layout of the Pando class, so they must be set here
+//-- and not in the sketch (the library is compiled on its own)
+
+//-- Motion profiler: records planned versus actual timing of every move.
+//-- Print the records with Pando.dumpProfile()
+// #define PANDO_PROFILER
+
+//-- Number of moves kept in the profiler ring buffer
+#define PROFILER_RECORDS    16
+
+//-- Motion watchdog: detaches the servos when the tick stalls while they
+//-- hold torque (a sketch stuck in Serial.read(), a locked I2C bus...).
+//-- It takes the AVR watchdog interrupt. Uncomment it here or pass
+//-- -DPANDO_WATCHDOG to the whole build: the sketch cannot set it
+// #define PANDO_WATCHDOG
+
+//-- Longest time without a tick while a pose or a gait runs (ms). On AVR it
+//-- is rounded up to a hardware timeout (15, 30, 60, 120, 250, 500, 1000
+//-- or 2000 ms)
+#define WATCHDOG_TIMEOUT    500
+
+//-- Longest time without a tick while the servos hold a pose between two
+//-- motions (ms, a multiple of the hardware timeout on AVR). A sketch that
+//-- delay()s longer between motions must call Pando.update() or detach
+#define WATCHDOG_IDLE_TIMEOUT 5000
+
+#endif
@@ -0,0 +1,78 @@
+//--------------------------------------------------------------
+//-- Generated by tools/eye_assets.py from tools/eyes/expressions.txt
+//-- Do not edit: change the art and run the tool again.
+//-- The tables are static, include it from one .cpp only
+//--------------------------------------------------------------
+#ifndef Pando_eye_frames_h
+#define Pando_eye_frames_h
+
+#define FRAME_SMILE             0
+#define FRAME_HAPPY_OPEN        1
+#define FRAME_HAPPY_CLOSED      2
+#define FRAME_HEART             3
+#define FRAME_CONFUSED          4
+#define FRAME_SAD               5
+#define FRAME_SAD_OPEN          6
+#define FRAME_SAD_CLOSED        7
+#define FRAME_ANGRY             8
+#define FRAME_FART_LEFT         9
+#define FRAME_FART_RIGHT        10
+#define FRAME_NORMAL            11
+#define FRAME_NORMAL_LEFT       12
+#define FRAME_NORMAL_RIGHT      13
+#define FRAME_NORMAL_UP         14
+#define FRAME_NORMAL_UP_LEFT    15
+#define FRAME_NORMAL_UP_RIGHT   16
+#define FRAME_BIG_ROUND         17
+#define FRAME_SURPRISED         18
+#define FRAME_SMALL_HEART       19
+
+#define EYE_FRAMES              20
+#define EYE_SHAPES              17
+
+//-- Every eye once, from its left column. One byte per column, bit 7 the top row
+static const uint8_t eye_shapes[EYE_SHAPES][EYE_SHAPE_SIZE] PROGMEM = {
+  { 0x18, 0x30, 0x30, 0x18, 0x0C, 0x00, 0x00, 0x00 },   //-- smile
+  { 0x1E, 0x20, 0x20, 0x20, 0x1E, 0x00, 0x00, 0x00 },   //-- happyOpen
+  { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00, 0x00 },   //-- happyClosed
+  { 0x30, 0x78, 0x7C, 0x3E, 0x7C, 0x78, 0x30, 0x00 },   //-- heart
+  { 0x1C, 0x22, 0x22, 0x22, 0x1C, 0x00, 0x00, 0x00 },   //-- confused
+  { 0x08, 0x04, 0x04, 0x04, 0x04, 0x08, 0x00, 0x00 },   //-- sad
+  { 0x0C, 0x1E, 0x1E, 0x3E, 0x3C, 0x10, 0x00, 0x00 },   //-- sadOpen
+  { 0x02, 0x04, 0x08, 0x10, 0x00, 0x00, 0x00, 0x00 },   //-- sadClosed
+  { 0x78, 0x3C, 0x1E, 0x0E, 0x04, 0x00, 0x00, 0x00 },   //-- angry
+  { 0x0C, 0x1A, 0x1A, 0x12, 0x12, 0x0C, 0x00, 0x00 },   //-- fartLeft
+  { 0x1C, 0x22, 0x2E, 0x2E, 0x22, 0x1C, 0x00, 0x00 },   //-- normal
+  { 0x1C, 0x2E, 0x2E, 0x22, 0x22, 0x1C, 0x00, 0x00 },   //-- normalLeft
+  { 0x1C, 0x22, 0x3A, 0x3A, 0x22, 0x1C, 0x00, 0x00 },   //-- normalUp
+  { 0x1C, 0x3A, 0x3A, 0x22, 0x22, 0x1C, 0x00, 0x00 },   //-- normalUpLeft
+  { 0x3C, 0x7E, 0x7E, 0x3C, 0x00, 0x00, 0x00, 0x00 },   //-- bigRound
+  { 0x1C, 0x22, 0x2A, 0x22, 0x1C, 0x00, 0x00, 0x00 },   //-- surprised
+  { 0x10, 0x38, 0x1C, 0x38, 0x10, 0x00, 0x00, 0x00 }   //-- smallHeart
+};
+
+//-- The eyes of every frame: shape and column of the left eye, then of the right one
+static const uint8_t eye_layouts[EYE_FRAMES][EYE_LAYOUT_SIZE] PROGMEM = {
+  { 0, 4, EYE_MIRROR | 0, 12 },                  //-- smile
+  { 1, 4, 1, 15 },                               //-- happyOpen
+  { 2, 4, 2, 16 },                               //-- happyClosed
+  { 3, 3, 3, 14 },                               //-- heart
+  { 4, 4, 4, 15 },                               //-- confused
+  { 5, 3, 5, 15 },                               //-- sad
+  { 6, 4, EYE_MIRROR | 6, 13 },                  //-- sadOpen
+  { 7, 5, EYE_MIRROR | 7, 11 },                  //-- sadClosed
+  { 8, 4, EYE_MIRROR | 8, 12 },                  //-- angry
+  { 9, 3, 9, 15 },                               //-- fartLeft
+  { EYE_MIRROR | 9, 1, EYE_MIRROR | 9, 13 },     //-- fartRight
+  { 10, 4, 10, 14 },                             //-- normal
+  { 11, 4, 11, 14 },                             //-- normalLeft
+  { EYE_MIRROR | 11, 2, EYE_MIRROR | 11, 12 },   //-- normalRight
+  { 12, 4, 12, 14 },                             //-- normalUp
+  { 13, 4, 13, 14 },                             //-- normalUpLeft
+  { EYE_MIRROR | 13, 2, EYE_MIRROR | 13, 12 },   //-- normalUpRight
+  { 14, 5, 14, 16 },                             //-- bigRound
+  { 15, 4, 15, 15 },                             //-- surprised
+  { 16, 4, 16, 15 }                              //-- smallHeart
+};
+
+#endif
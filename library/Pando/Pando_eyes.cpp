@@ -0,0 +1,269 @@
+//--------------------------------------------------------------
+//-- Pando eyes
+//-- The eye expressions, as frames ready to copy to the display,
+//-- the eye animations, the procedural eyes and the tweening
+//--------------------------------------------------------------
+#include "Pando_eyes.h"
+
+#if defined(ARDUINO) && ARDUINO >= 100
+  #include "Arduino.h"
+#elif defined(ARDUINO)
+  #include "WProgram.h"
+#else
+  //-- Host build (tools/eye_clips.cpp)
+  #include <string.h>
+  #define PROGMEM
+  #define pgm_read_byte(address) (*(const uint8_t *)(address))
+  #define pgm_read_ptr(address) (*(const void * const *)(address))
+  #define memcpy_P memcpy
+  #define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+#endif
+
+#define NO_FRAME  0xFF
+
+//-- The eyes, from tools/eyes/expressions.txt (tools/eye_assets.py)
+#include "Pando_eye_frames.h"
+
+//-- Frame of every expression id
+static const uint8_t eye_index[EYES] PROGMEM = {
+  FRAME_SMILE,            //-- smile
+  FRAME_HAPPY_OPEN,       //-- happyOpen
+  FRAME_HAPPY_CLOSED,     //-- happyClosed
+  FRAME_HEART,            //-- heart
+  NO_FRAME,               //-- bigSurprise
+  NO_FRAME,               //-- smallSurprise
+  NO_FRAME,               //-- tongueOut
+  NO_FRAME,               //-- vamp1
+  NO_FRAME,               //-- vamp2
+  NO_FRAME,               //-- lineMouth
+  FRAME_CONFUSED,         //-- confused
+  NO_FRAME,               //-- diagonal
+  FRAME_SAD,              //-- sad
+  FRAME_SAD_OPEN,         //-- sadOpen
+  FRAME_SAD_CLOSED,       //-- sadClosed
+  NO_FRAME,               //-- okMouth
+  NO_FRAME,               //-- xMouth
+  NO_FRAME,               //-- interrogation
+  NO_FRAME,               //-- thunder
+  NO_FRAME,               //-- culito
+  FRAME_ANGRY,            //-- angry
+  FRAME_FART_LEFT,        //-- fartLeft
+  FRAME_FART_RIGHT,       //-- fartRight
+  FRAME_NORMAL,           //-- normal
+  FRAME_NORMAL_LEFT,      //-- normalLeft
+  FRAME_NORMAL_RIGHT,     //-- normalRight
+  FRAME_NORMAL_UP,        //-- normalUp
+  FRAME_NORMAL_UP_LEFT,   //-- normalUpLeft
+  FRAME_NORMAL_UP_RIGHT,  //-- normalUpRight
+  FRAME_BIG_ROUND,        //-- bigRound
+  FRAME_SURPRISED,        //-- surprised
+  FRAME_SMALL_HEART       //-- smallHeart
+};
+
+//-- OR an eye into a frame, from a column. Mirrored, the columns of the shape
+//-- are read backwards
+static void drawEye(uint8_t *frame, uint8_t shape, uint8_t column){
+
+  if (shape == EYE_NO_SHAPE) return;
+
+  const uint8_t *columns = eye_shapes[shape & ~EYE_MIRROR];
+  int8_t step = 1;
+  if (shape & EYE_MIRROR) {
+    columns += EYE_SHAPE_SIZE - 1;
+    step = -1;
+  }
+
+  for (uint8_t i = 0; i < EYE_SHAPE_SIZE && column < EYE_FRAME_SIZE; i++, column++, columns += step)
+    frame[column] |= pgm_read_byte(columns);
+}
+
+bool eyeFrame(int expression, uint8_t *frame){
+
+  if (expression < 0 || expression >= EYES) return false;
+
+  uint8_t index = pgm_read_byte(&eye_index[expression]);
+  if (index == NO_FRAME) return false;
+
+  uint8_t layout[EYE_LAYOUT_SIZE];
+  memcpy_P(layout, eye_layouts[index], EYE_LAYOUT_SIZE);
+
+  memset(frame, 0, EYE_FRAME_SIZE);
+  drawEye(frame, layout[0], layout[1]);
+  drawEye(frame, layout[2], layout[3]);
+  return true;
+}
+
+
+static const uint8_t blink_animation[] PROGMEM = {
+  PLAY_ONCE, 2,
+  happyOpen, 40,
+  happyClosed, 10
+};
+
+static const uint8_t love_animation[] PROGMEM = {
+  PLAY_ONCE, 2,
+  smallHeart, 50,
+  heart, 50
+};
+
+static const uint8_t gaze_animation[] PROGMEM = {
+  PLAY_ONCE, 6,
+  normal, 10,
+  normalLeft, 10,
+  normalUpLeft, 10,
+  normalUp, 10,
+  normalUpRight, 10,
+  normalRight, 10
+};
+
+//-- Clips, from tools/eye_clips.cpp --emit
+static const uint8_t soft_blink_clip[] PROGMEM = {
+  EYE_CLIP | PLAY_ONCE, 7,
+  0x05, 0x43, 0x00, 0x81, 0x1C, 0x22, 0x41, 0x2E, 0x81, 0x22, 0x1C, 0x43, 0x00, 0x81, 0x1C, 0x22, 0x41, 0x2E, 0x81, 0x22, 0x1C, 0x43, 0x00, 0xC0,
+  0x03, 0x04, 0x80, 0x12, 0x41, 0x1E, 0x80, 0x12, 0x05, 0x80, 0x12, 0x41, 0x1E, 0x80, 0x12, 0xC0,
+  0x03, 0x03, 0x45, 0x0C, 0x03, 0x45, 0x0C, 0xC0,
+  0x08, 0x03, 0x45, 0x08, 0x03, 0x45, 0x08, 0xC0,
+  0x03, 0x03, 0x45, 0x0C, 0x03, 0x45, 0x0C, 0xC0,
+  0x03, 0x03, 0x81, 0x1C, 0x12, 0x41, 0x1E, 0x81, 0x12, 0x1C, 0x03, 0x81, 0x1C, 0x12, 0x41, 0x1E, 0x81, 0x12, 0x1C, 0xC0,
+  0x05, 0x04, 0x80, 0x22, 0x41, 0x2E, 0x80, 0x22, 0x05, 0x80, 0x22, 0x41, 0x2E, 0x80, 0x22, 0xC0
+};
+
+static const uint8_t look_around_clip[] PROGMEM = {
+  EYE_CLIP | PLAY_LOOP, 9,
+  0x50, 0x43, 0x00, 0x81, 0x1C, 0x22, 0x41, 0x2E, 0x81, 0x22, 0x1C, 0x43, 0x00, 0x81, 0x1C, 0x22, 0x41, 0x2E, 0x81, 0x22, 0x1C, 0x43, 0x00, 0xC0,
+  0x3C, 0x04, 0x41, 0x2E, 0x41, 0x22, 0x05, 0x41, 0x2E, 0x41, 0x22, 0xC0,
+  0x28, 0x04, 0x41, 0x3A, 0x07, 0x41, 0x3A, 0xC0,
+  0x14, 0x04, 0x80, 0x22, 0x41, 0x3A, 0x06, 0x80, 0x22, 0x41, 0x3A, 0xC0,
+  0x28, 0x05, 0x80, 0x22, 0x41, 0x3A, 0x06, 0x80, 0x22, 0x41, 0x3A, 0xC0,
+  0x3C, 0x06, 0x41, 0x2E, 0x07, 0x41, 0x2E, 0xC0,
+  0x08, 0x03, 0x45, 0x08, 0x03, 0x45, 0x08, 0xC0,
+  0x1E, 0x03, 0x80, 0x1C, 0x41, 0x22, 0x41, 0x2E, 0x80, 0x1C, 0x03, 0x80, 0x1C, 0x41, 0x22, 0x41, 0x2E, 0x80, 0x1C, 0xC0,
+  0x28, 0x05, 0x41, 0x2E, 0x80, 0x22, 0x06, 0x41, 0x2E, 0x80, 0x22, 0xC0
+};
+
+static const uint8_t * const eye_animations[ANIMATIONS] PROGMEM = {
+  blink_animation,
+  love_animation,
+  gaze_animation,
+  soft_blink_clip,
+  look_around_clip
+};
+
+//-- PROGMEM animation, NULL if there is no such one
+const uint8_t *eyeAnimation(int animation){
+
+  if (animation < 0 || animation >= ANIMATIONS) return NULL;
+
+  return (const uint8_t *)pgm_read_ptr(&eye_animations[animation]);
+}
+
+
+const uint8_t *decodeEyeFrame(const uint8_t *data, uint8_t *frame, uint32_t &changed){
+
+  uint8_t column = 0;
+  changed = 0;
+
+  for (;;) {
+    uint8_t token = pgm_read_byte(data++);
+    uint8_t count = (token & CLIP_COUNT) + 1;
+
+    switch (token & CLIP_TOKEN) {
+      case CLIP_END:
+        return data;
+      case CLIP_SKIP:
+        column += count;
+        break;
+      default:
+        for (; count > 0; count--, column++) {
+          uint8_t value = pgm_read_byte(data);
+          if ((token & CLIP_TOKEN) == CLIP_LITERAL || count == 1) data++;
+          if (column < EYE_FRAME_SIZE && frame[column] != value) {
+            frame[column] = value;
+            changed |= 1UL << column;
+          }
+        }
+    }
+  }
+}
+
+
+//-- Procedural eye shapes
+struct EyeShape {
+  uint8_t columns[EYE_WIDTH];
+  int8_t x_min, x_max;          //-- Pupil range
+  int8_t y_min, y_max;
+  bool hole;                    //-- The pupil is cleared, not lit
+};
+
+static const EyeShape procedural_shapes[SHAPES] PROGMEM = {
+  { {0x1C, 0x22, 0x22, 0x22, 0x22, 0x1C}, -1, 1, -1, 0, false },    //-- SHAPE_ROUND
+  { {0x00, 0x3C, 0x7E, 0x7E, 0x3C, 0x00}, -1, 1, -2, 0, true }      //-- SHAPE_SOLID
+};
+
+//-- The pupil is 2x2. At (0, 0) it takes the columns 2-3 of the eye, rows 4-5
+#define PUPIL_COLUMN  2
+#define PUPIL_ROW     4
+
+//---------------------------------------------------------
+//-- Every column is one byte built with a few masks and shifts
+//-- (shape | pupil) & lids, so a redraw is a couple hundred cycles.
+//-- Both eyes look the same way
+//---------------------------------------------------------
+void renderEyes(uint8_t *frame, const EyeParams &eye){
+
+  EyeShape shape;
+  memcpy_P(&shape, &procedural_shapes[eye.shape < SHAPES ? eye.shape : SHAPE_ROUND], sizeof(shape));
+
+  int8_t x = constrain(eye.pupil_x, shape.x_min, shape.x_max);
+  int8_t y = constrain(eye.pupil_y, shape.y_min, shape.y_max);
+  uint8_t pupil = 0xC0 >> (PUPIL_ROW + y);
+
+  //-- Rows the lids leave open, from the top row of the shape down
+  uint8_t all = 0;
+  for (int c = 0; c < EYE_WIDTH; c++) all |= shape.columns[c];
+  uint8_t top = 0, bottom = 7;
+  while (top < 7 && !(all & (0x80 >> top))) top++;
+  while (bottom > 0 && !(all & (0x80 >> bottom))) bottom--;
+  top += eye.lid_top;
+  bottom = eye.lid_bottom > bottom ? 0 : bottom - eye.lid_bottom;
+
+  uint8_t open = 0, lid = 0;
+  if (top <= bottom && top < 8) {
+    open = (0xFF >> top) & (0xFF << (7 - bottom));
+    if (eye.lid_top > 0) lid |= 0x80 >> top;
+    if (eye.lid_bottom > 0) lid |= 0x80 >> bottom;
+  }
+  else lid = 0x80 >> ((top + bottom) / 2 < 8 ? (top + bottom) / 2 : 7);    //-- Closed
+
+  memset(frame, 0, EYE_FRAME_SIZE);
+  for (int c = 0; c < EYE_WIDTH; c++) {
+    uint8_t column = shape.columns[c];
+    if (c - PUPIL_COLUMN == x || c - PUPIL_COLUMN == x + 1)
+      column = shape.hole ? column & ~pupil : column | pupil;
+    column = (column & open) | (shape.columns[c] ? lid : 0);
+
+    frame[EYE_LEFT_COLUMN + c] = column;
+    frame[EYE_RIGHT_COLUMN + c] = column;
+  }
+}
+
+
+//-- 4x4 ordered dither: the order in which the pixels switch
+static const uint8_t dissolve_order[4][4] PROGMEM = {
+  { 0,  8,  2, 10},
+  {12,  4, 14,  6},
+  { 3, 11,  1,  9},
+  {15,  7, 13,  5}
+};
+
+uint8_t dissolveMask(uint8_t column, uint8_t step){
+
+  uint8_t level = step * 16 / TWEEN_STEPS;
+  uint8_t mask = 0;
+
+  //-- Rows r and r+4 share their order
+  for (int r = 0; r < 4; r++)
+    if (pgm_read_byte(&dissolve_order[column & 3][r]) < level) mask |= 0x88 >> r;
+
+  return mask;
+}
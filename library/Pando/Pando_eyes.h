@@ -1,6 +1,8 @@
 #ifndef Pando_eyes_h
 #define Pando_eyes_h
 
+#include <stdint.h>
+
 // #include "DFRobot_HT1632C.h"
 
 // #define DATA 11
@@ -96,6 +98,116 @@
 #define fartLeft            21
 #define fartRight           22               
 
+#define normal              23
+#define normalLeft          24
+#define normalRight         25
+#define normalUp            26
+#define normalUpLeft        27
+#define normalUpRight       28
+
+#define bigRound            29
+#define surprised           30
+#define smallHeart          31
+
+#define EYES                32
+
+//-- A frame is 24 bytes, one byte per column (left to right), bit 7 the
+//-- top row. Every eye is stored once (Pando_eye_frames.h): an expression
+//-- gives the shape and column of each eye, and the right eye is often
+//-- the left one again or its mirror
+#define EYE_FRAME_SIZE      24
+#define EYE_SHAPE_SIZE      8     //-- Columns of a stored eye
+#define EYE_LAYOUT_SIZE     4     //-- Left shape, column, right shape, column
+#define EYE_MIRROR          0x80  //-- With a shape: drawn right to left
+#define EYE_NO_SHAPE        0x7F  //-- No eye on that side
+
+//-- Draw an expression in a frame buffer. False if the id has no drawing
+bool eyeFrame(int expression, uint8_t *frame);
+
+//-- Eye animations (see Pando::playEyes)
+#define ANIM_BLINK          0
+#define ANIM_LOVE           1
+#define ANIM_GAZE           2
+#define ANIM_SOFT_BLINK     3
+#define ANIM_LOOK_AROUND    4
+
+#define ANIMATIONS          5
+
+//-- What an animation does after its last frame
+#define PLAY_ONCE           0     //-- Stops, the last frame stays
+#define PLAY_LOOP           1     //-- Starts again
+#define PLAY_PINGPONG       2     //-- Goes back to the first frame, and so on
+#define PLAY_DEFAULT        0xFF  //-- The mode of the animation
+
+//-- An animation is mode, frame count, then expression and time (x10 ms)
+//-- of every frame, in PROGMEM.
+//-- With EYE_CLIP in the mode, it is a clip: the frames are stored
+//-- themselves, compressed. Every frame is its time (x10 ms), then tokens
+//-- over the 24 columns of the previous frame, then CLIP_END. The first
+//-- frame has no skips, so a clip can start over anything. Clips can not
+//-- play backwards: PLAY_PINGPONG loops them (tools/eye_clips.cpp builds them)
+#define EYE_CLIP            0x80
+
+#define CLIP_SKIP           0x00  //-- count columns stay
+#define CLIP_RUN            0x40  //-- count columns take the next byte
+#define CLIP_LITERAL        0x80  //-- count columns take the next count bytes
+#define CLIP_END            0xC0  //-- The other columns stay
+#define CLIP_TOKEN          0xC0
+#define CLIP_COUNT          0x3F  //-- count - 1 (1 to 64)
+
+const uint8_t *eyeAnimation(int animation);
+
+//-- Decode a clip frame straight into a frame buffer that holds the previous
+//-- one. Returns the next frame. The columns that changed are set in changed
+const uint8_t *decodeEyeFrame(const uint8_t *data, uint8_t *frame, uint32_t &changed);
+
+//-- Procedural eyes: both eyes drawn from parameters (see renderEyes)
+#define SHAPE_ROUND         0     //-- Outline, the pupil is lit
+#define SHAPE_SOLID         1     //-- Filled, the pupil is a hole
+#define SHAPES              2
+
+#define EYE_WIDTH           6     //-- Columns of an eye
+#define EYE_LEFT_COLUMN     4
+#define EYE_RIGHT_COLUMN    14
+#define GAZE_STEP           30    //-- Degrees per pupil pixel (Pando::lookAt)
+
+struct EyeParams {
+  int8_t pupil_x;       //-- Pixels from the center, left < 0 (clamped to the shape)
+  int8_t pupil_y;       //-- Pixels from the center, up < 0
+  uint8_t lid_top;      //-- Rows hidden by the upper lid
+  uint8_t lid_bottom;   //-- Rows hidden by the lower lid
+  uint8_t shape;        //-- SHAPE_*
+};
+
+//-- Draw both eyes in a frame buffer (EYE_FRAME_SIZE bytes, bit 7 the top row)
+void renderEyes(uint8_t *frame, const EyeParams &eye);
+
+//-- Tweening (see Pando::tweenEyes): the pixels switch from one expression
+//-- to the next in an ordered dissolve pattern, over TWEEN_STEPS frames
+#define TWEEN_STEPS         8
+#define TWEEN_TIME          200   //-- Default transition time (ms)
+
+//-- Rows of a column that show the new expression at a step (0 to TWEEN_STEPS).
+//-- A pixel switches once, so the mask only grows with the step
+uint8_t dissolveMask(uint8_t column, uint8_t step);
+
+//-- Auto-blink (see Pando::setAutoBlink): the eyes close for BLINK_TIME_MIN
+//-- to BLINK_TIME_MAX ms, every interval/2 to 3*interval/2 ms
+#define BLINK_INTERVAL      4000  //-- Default mean time between blinks (ms)
+#define BLINK_TIME_MIN      80
+#define BLINK_TIME_MAX      180
+
+//-- Pando::eyes when the display shows something else than eyes (text):
+//-- there is nothing to blink
+#define EYES_NONE           -2
+
+//-- What the eyes sent to the display (see Pando::getDisplayStats)
+struct DisplayStats {
+  unsigned long updates;      //-- Writes to the display
+  unsigned long bits;         //-- Bits sent (see DFRobot_HT1632C::flush)
+  unsigned int blinks;        //-- Auto-blinks
+};
+
 // class Pando_eyes
 // {
 //   public:
@@ -0,0 +1,31 @@
+#ifndef Pando_gaits_h
+#define Pando_gaits_h
+
+//***********************************************************************************
+//*********************************GAIT DEFINES**************************************
+//***********************************************************************************
+//-- Oscillating gaits. _execute() uses them to steer and to count cycles.
+//-- GAIT_WALK to GAIT_FLAPPING take a dir, the others ignore it
+
+#define GAIT_NONE             0
+#define GAIT_WALK             1
+#define GAIT_TURN             2
+#define GAIT_MOONWALKER       3
+#define GAIT_CRUSAITO         4
+#define GAIT_FLAPPING         5
+#define GAIT_UPDOWN           6
+#define GAIT_SWING            7
+#define GAIT_TIPTOE_SWING     8
+#define GAIT_JITTER           9
+#define GAIT_ASCENDING_TURN   10
+
+#define GAITS                 11
+
+//-- Other motions, to tell what Pando is doing
+#define MOVE_POSE             11
+#define MOVE_HOME             12
+#define MOVE_JUMP             13
+#define MOVE_BEND             14
+#define MOVE_SHAKE_LEG        15
+
+#endif
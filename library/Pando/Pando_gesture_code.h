@@ -0,0 +1,467 @@
+#ifndef Pando_gesture_code_h
+#define Pando_gesture_code_h
+
+//***********************************************************************************
+//*********************************GESTURE PROGRAMS**********************************
+//***********************************************************************************
+//-- Bytecode of the built-in gestures and songs (see Pando_timeline.h).
+//-- Only Pando.cpp includes this file: the programs live in flash once
+
+const uint8_t happy_code[] PROGMEM = {
+  G_TONE(note_E5, 50, 30),
+  G_EYES(smile),
+  G_SYNC(SYNC_SOUND),
+  G_BEND(1500, 2000, 1.05, 15, 8),        //-- S_happy_short while swinging
+  G_GAIT(GAIT_SWING, 1, 800, 20, 0),
+  G_SYNC(SYNC_SOUND),
+  G_WAIT(100),
+  G_BEND(1900, 2500, 1.05, 10, 8),
+  G_SYNC(SYNC_SERVOS),
+  G_BEND(1500, 2000, 1.05, 15, 8),        //-- S_happy_short going home
+  G_HOME,
+  G_SYNC(SYNC_SOUND),
+  G_WAIT(100),
+  G_BEND(1900, 2500, 1.05, 10, 8),
+  G_SYNC(SYNC_ALL),
+  G_EYES(happyOpen),
+  G_END
+};
+
+const uint8_t superhappy_code[] PROGMEM = {
+  G_EYES(happyOpen),
+  G_BEND(1500, 2500, 1.05, 20, 8),        //-- S_happy
+  G_GAIT(GAIT_TIPTOE_SWING, 1, 500, 20, 0),
+  G_SYNC(SYNC_SOUND),
+  G_BEND(2499, 1500, 1.05, 25, 8),
+  G_SYNC(SYNC_SERVOS),
+  G_EYES(happyClosed),
+  G_GAIT(GAIT_TIPTOE_SWING, 1, 500, 20, 0),
+  G_SYNC(SYNC_SOUND),
+  G_EYES(happyOpen),
+  G_BEND(2000, 6000, 1.05, 8, 3),         //-- S_superHappy
+  G_SYNC(SYNC_SOUND),
+  G_WAIT(50),
+  G_BEND(5999, 2000, 1.05, 13, 2),
+  G_SYNC(SYNC_SERVOS),
+  G_EYES(happyClosed),
+  G_HOME,
+  G_SYNC(SYNC_ALL),
+  G_EYES(happyOpen),
+  G_END
+};
+
+const uint8_t sad_code[] PROGMEM = {
+  G_EYES(sadOpen),
+  G_POSE(POSE_SAD, 700),
+  G_BEND(880, 830, 1.02, 20, 200),
+  G_SYNC(SYNC_SOUND),
+  G_EYES(sadClosed),
+  G_BEND(830, 790, 1.02, 20, 200),
+  G_SYNC(SYNC_SOUND),
+  G_EYES(sadOpen),
+  G_BEND(790, 740, 1.02, 20, 200),
+  G_SYNC(SYNC_SOUND),
+  G_EYES(sadClosed),
+  G_BEND(740, 700, 1.02, 20, 200),
+  G_SYNC(SYNC_SOUND),
+  G_EYES(sadOpen),
+  G_BEND(700, 669, 1.02, 20, 200),
+  G_SYNC(SYNC_SOUND),
+  G_WAIT(180),
+  G_HOME,
+  G_END
+};
+
+const uint8_t sleeping_code[] PROGMEM = {
+  G_POSE(POSE_BED, 700),
+  G_EYES(happyClosed),
+  G_LOOP(4),
+    G_BENDS(100, 100, 100, 2, 1.04, 10, 10),    //-- Snore: 100 -> 300
+    G_SYNC(SYNC_SOUND),
+    G_BEND(300, 500, 1.04, 10, 10),
+    G_SYNC(SYNC_SOUND),
+    G_WAIT(500),
+    G_BENDS(400, -150, -150, 2, 1.04, 10, 1),   //-- 400 -> 100
+    G_SYNC(SYNC_SOUND),
+    G_WAIT(500),
+  G_NEXT,
+  G_BEND(700, 900, 1.03, 16, 4),                //-- S_cuddly
+  G_SYNC(SYNC_SOUND),
+  G_BEND(899, 650, 1.01, 18, 7),
+  G_HOME,
+  G_END
+};
+
+const uint8_t fart_code[] PROGMEM = {
+  G_POSE(POSE_FART_1, 500),
+  G_SYNC(SYNC_SERVOS),
+  G_WAIT(300),
+  G_EYES(fartLeft),
+  G_BEND(1600, 3000, 1.02, 2, 15),        //-- S_fart1
+  G_SYNC(SYNC_SOUND),
+  G_EYES(fartRight),
+  G_WAIT(250),
+  G_POSE(POSE_FART_2, 500),
+  G_SYNC(SYNC_SERVOS),
+  G_WAIT(300),
+  G_EYES(fartLeft),
+  G_BEND(2000, 6000, 1.02, 2, 20),        //-- S_fart2
+  G_SYNC(SYNC_SOUND),
+  G_EYES(fartRight),
+  G_WAIT(250),
+  G_POSE(POSE_FART_3, 500),
+  G_SYNC(SYNC_SERVOS),
+  G_WAIT(300),
+  G_EYES(fartLeft),
+  G_BEND(1600, 4000, 1.02, 2, 20),        //-- S_fart3
+  G_SYNC(SYNC_SOUND),
+  G_BEND(4000, 3000, 1.02, 2, 20),
+  G_SYNC(SYNC_SOUND),
+  G_EYES(fartRight),
+  G_WAIT(300),
+  G_HOME,
+  G_SYNC(SYNC_SERVOS),
+  G_WAIT(500),
+  G_EYES(happyOpen),
+  G_END
+};
+
+const uint8_t confused_code[] PROGMEM = {
+  G_POSE(POSE_CONFUSED, 300),
+  G_EYES(confused),
+  G_BEND(1000, 1700, 1.03, 8, 2),         //-- S_confused
+  G_SYNC(SYNC_SOUND),
+  G_BEND(1699, 500, 1.04, 8, 3),
+  G_SYNC(SYNC_SOUND),
+  G_BEND(1000, 1700, 1.05, 9, 10),
+  G_SYNC(SYNC_ALL),
+  G_WAIT(500),
+  G_HOME,
+  G_END
+};
+
+const uint8_t love_code[] PROGMEM = {
+  G_EYES(heart),
+  G_BEND(700, 900, 1.03, 16, 4),          //-- S_cuddly while dancing
+  G_GAIT(GAIT_CRUSAITO, 2, 1500, 15, 1),
+  G_SYNC(SYNC_SOUND),
+  G_BEND(899, 650, 1.01, 18, 7),
+  G_SYNC(SYNC_SERVOS),
+  G_HOME,
+  G_BEND(1500, 2000, 1.05, 15, 8),        //-- S_happy_short
+  G_SYNC(SYNC_SOUND),
+  G_WAIT(100),
+  G_BEND(1900, 2500, 1.05, 10, 8),
+  G_END
+};
+
+const uint8_t angry_code[] PROGMEM = {
+  G_POSE(POSE_ANGRY, 300),
+  G_EYES(angry),
+  G_TONE(note_A5, 100, 30),
+  G_SYNC(SYNC_SOUND),
+  G_BEND(note_A5, note_D6, 1.02, 7, 4),
+  G_SYNC(SYNC_SOUND),
+  G_BEND(note_D6, note_G6, 1.02, 10, 1),
+  G_SYNC(SYNC_SOUND),
+  G_BEND(note_G6, note_A5, 1.02, 10, 1),
+  G_SYNC(SYNC_SOUND),
+  G_WAIT(15),
+  G_BEND(note_A5, note_E5, 1.02, 20, 4),
+  G_SYNC(SYNC_SOUND),
+  G_WAIT(400),
+  G_POSE(POSE_HEAD_LEFT, 200),            //-- Growls shaking the head
+  G_BEND(note_A5, note_D6, 1.02, 20, 4),
+  G_SYNC(SYNC_ALL),
+  G_POSE(POSE_HEAD_RIGHT, 200),
+  G_BEND(note_A5, note_E5, 1.02, 20, 4),
+  G_SYNC(SYNC_ALL),
+  G_HOME,
+  G_END
+};
+
+const uint8_t fretful_code[] PROGMEM = {
+  G_EYES(angry),
+  G_BEND(note_A5, note_D6, 1.02, 20, 4),
+  G_SYNC(SYNC_SOUND),
+  G_BEND(note_A5, note_E5, 1.02, 20, 4),
+  G_SYNC(SYNC_SOUND),
+  G_WAIT(300),
+  G_LOOP(4),
+    G_POSE(POSE_FRETFUL, 100),
+    G_SYNC(SYNC_SERVOS),
+    G_HOME,
+    G_SYNC(SYNC_SERVOS),
+  G_NEXT,
+  G_WAIT(500),
+  G_END
+};
+
+const uint8_t magic_code[] PROGMEM = {
+  G_LOOP(4),
+    G_BENDS(400, 100, 100, 6, 1.04, 10, 10),    //-- 400 -> 1000
+    G_SYNC(SYNC_SOUND),
+    G_BEND(900, 1100, 1.04, 10, 10),
+    G_SYNC(SYNC_SOUND),
+    G_BENDS(1000, 100, -100, 6, 1.04, 10, 10),  //-- 1000 -> 400
+    G_SYNC(SYNC_SOUND),
+  G_NEXT,
+  G_WAIT(300),
+  G_EYES(happyOpen),
+  G_END
+};
+
+const uint8_t wave_code[] PROGMEM = {
+  G_LOOP(2),
+    G_BENDS(500, 100, 101, 20, 1.02, 10, 10),     //-- 500 -> 2520
+    G_SYNC(SYNC_SOUND),
+    G_BENDS(2520, -100, -101, 20, 1.02, 10, 10),  //-- 2520 -> 500
+    G_SYNC(SYNC_SOUND),
+  G_NEXT,
+  G_WAIT(100),
+  G_EYES(happyOpen),
+  G_END
+};
+
+const uint8_t victory_code[] PROGMEM = {
+  G_POSE(POSE_VICTORY, 960),              //-- Rising feet, rising pitch
+  G_BENDS(1600, 1, 20, 60, 1.02, 15, 1),
+  G_SYNC(SYNC_ALL),
+  G_POSE(POSE_STAND, 960),
+  G_BENDS(2800, 1, 20, 60, 1.02, 15, 1),
+  G_SYNC(SYNC_ALL),
+  G_GAIT(GAIT_TIPTOE_SWING, 1, 500, 20, 0),
+  G_BEND(2000, 6000, 1.05, 8, 3),         //-- S_superHappy
+  G_SYNC(SYNC_SOUND),
+  G_WAIT(50),
+  G_BEND(5999, 2000, 1.05, 13, 2),
+  G_SYNC(SYNC_SERVOS),
+  G_GAIT(GAIT_TIPTOE_SWING, 1, 500, 20, 0),
+  G_SYNC(SYNC_ALL),
+  G_HOME,
+  G_SYNC(SYNC_SERVOS),
+  G_EYES(happyOpen),
+  G_END
+};
+
+const uint8_t fail_code[] PROGMEM = {
+  G_POSE(POSE_BEND_1, 300),
+  G_TONE(900, 200, 1),
+  G_SYNC(SYNC_ALL),
+  G_POSE(POSE_BEND_2, 300),
+  G_TONE(600, 200, 1),
+  G_SYNC(SYNC_ALL),
+  G_POSE(POSE_BEND_3, 300),
+  G_TONE(300, 200, 1),
+  G_SYNC(SYNC_ALL),
+  G_POSE(POSE_BEND_4, 300),
+  G_SYNC(SYNC_SERVOS),
+  G_DETACH,
+  G_TONE(150, 2200, 1),
+  G_SYNC(SYNC_SOUND),
+  G_WAIT(600),
+  G_EYES(happyOpen),
+  G_HOME,
+  G_END
+};
+
+const uint8_t thinking_code[] PROGMEM = {
+  G_EYES(normal),
+  G_POSE(POSE_FRETFUL, 50),
+  G_SYNC(SYNC_SERVOS),
+  G_HOME,
+  G_SYNC(SYNC_SERVOS),
+  G_EYES(normalLeft),
+  G_POSE(POSE_FRETFUL, 50),
+  G_SYNC(SYNC_SERVOS),
+  G_HOME,
+  G_SYNC(SYNC_SERVOS),
+  G_EYES(normalUpLeft),
+  G_POSE(POSE_FRETFUL, 50),
+  G_SYNC(SYNC_SERVOS),
+  G_HOME,
+  G_SYNC(SYNC_SERVOS),
+  G_EYES(normalUp),
+  G_POSE(POSE_FRETFUL, 50),
+  G_SYNC(SYNC_SERVOS),
+  G_HOME,
+  G_SYNC(SYNC_SERVOS),
+  G_EYES(normalUpRight),
+  G_POSE(POSE_FRETFUL, 50),
+  G_SYNC(SYNC_SERVOS),
+  G_HOME,
+  G_SYNC(SYNC_SERVOS),
+  G_EYES(normalRight),
+  G_POSE(POSE_FRETFUL, 50),
+  G_SYNC(SYNC_SERVOS),
+  G_HOME,
+  G_END
+};
+
+//-- Songs: sound operations only, sing() plays them on the sound track
+
+const uint8_t connection_song[] PROGMEM = {
+  G_TONE(note_E5, 50, 30), G_SYNC(SYNC_SOUND),
+  G_TONE(note_E6, 55, 25), G_SYNC(SYNC_SOUND),
+  G_TONE(note_A6, 60, 10),
+  G_END
+};
+
+const uint8_t disconnection_song[] PROGMEM = {
+  G_TONE(note_E5, 50, 30), G_SYNC(SYNC_SOUND),
+  G_TONE(note_A6, 55, 25), G_SYNC(SYNC_SOUND),
+  G_TONE(note_E6, 50, 10),
+  G_END
+};
+
+const uint8_t buttonPushed_song[] PROGMEM = {
+  G_BEND(note_E6, note_G6, 1.03, 20, 2), G_SYNC(SYNC_SOUND),
+  G_WAIT(30),
+  G_BEND(note_E6, note_D7, 1.04, 10, 2),
+  G_END
+};
+
+const uint8_t mode1_song[] PROGMEM = {
+  G_BEND(note_E6, note_A6, 1.02, 30, 10),    //-- 1318.51 to 1760
+  G_END
+};
+
+const uint8_t mode2_song[] PROGMEM = {
+  G_BEND(note_G6, note_D7, 1.03, 30, 10),    //-- 1567.98 to 2349.32
+  G_END
+};
+
+const uint8_t mode3_song[] PROGMEM = {
+  G_TONE(note_E6, 50, 100), G_SYNC(SYNC_SOUND),
+  G_TONE(note_G6, 50, 80), G_SYNC(SYNC_SOUND),
+  G_TONE(note_D7, 300, 0),
+  G_END
+};
+
+const uint8_t surprise_song[] PROGMEM = {
+  G_BEND(800, 2150, 1.02, 10, 1), G_SYNC(SYNC_SOUND),
+  G_BEND(2149, 800, 1.03, 7, 1),
+  G_END
+};
+
+const uint8_t OhOoh_song[] PROGMEM = {
+  G_BEND(880, 2000, 1.04, 8, 3), G_SYNC(SYNC_SOUND),    //-- A5 = 880
+  G_WAIT(200),
+  G_LOOP(22),                                           //-- Steps of the bend above
+    G_TONE(note_B5, 5, 10), G_SYNC(SYNC_SOUND),
+  G_NEXT,
+  G_END
+};
+
+const uint8_t OhOoh2_song[] PROGMEM = {
+  G_BEND(1880, 3000, 1.03, 8, 3), G_SYNC(SYNC_SOUND),
+  G_WAIT(200),
+  G_LOOP(16),
+    G_TONE(note_C6, 10, 10), G_SYNC(SYNC_SOUND),
+  G_NEXT,
+  G_END
+};
+
+const uint8_t cuddly_song[] PROGMEM = {
+  G_BEND(700, 900, 1.03, 16, 4), G_SYNC(SYNC_SOUND),
+  G_BEND(899, 650, 1.01, 18, 7),
+  G_END
+};
+
+const uint8_t sleeping_song[] PROGMEM = {
+  G_BEND(100, 500, 1.04, 10, 10), G_SYNC(SYNC_SOUND),
+  G_WAIT(500),
+  G_BEND(400, 100, 1.04, 10, 1),
+  G_END
+};
+
+const uint8_t happy_song[] PROGMEM = {
+  G_BEND(1500, 2500, 1.05, 20, 8), G_SYNC(SYNC_SOUND),
+  G_BEND(2499, 1500, 1.05, 25, 8),
+  G_END
+};
+
+const uint8_t superHappy_song[] PROGMEM = {
+  G_BEND(2000, 6000, 1.05, 8, 3), G_SYNC(SYNC_SOUND),
+  G_WAIT(50),
+  G_BEND(5999, 2000, 1.05, 13, 2),
+  G_END
+};
+
+const uint8_t happy_short_song[] PROGMEM = {
+  G_BEND(1500, 2000, 1.05, 15, 8), G_SYNC(SYNC_SOUND),
+  G_WAIT(100),
+  G_BEND(1900, 2500, 1.05, 10, 8),
+  G_END
+};
+
+const uint8_t sad_song[] PROGMEM = {
+  G_BEND(880, 669, 1.02, 20, 200),
+  G_END
+};
+
+const uint8_t confused_song[] PROGMEM = {
+  G_BEND(1000, 1700, 1.03, 8, 2), G_SYNC(SYNC_SOUND),
+  G_BEND(1699, 500, 1.04, 8, 3), G_SYNC(SYNC_SOUND),
+  G_BEND(1000, 1700, 1.05, 9, 10),
+  G_END
+};
+
+const uint8_t fart1_song[] PROGMEM = {
+  G_BEND(1600, 3000, 1.02, 2, 15),
+  G_END
+};
+
+const uint8_t fart2_song[] PROGMEM = {
+  G_BEND(2000, 6000, 1.02, 2, 20),
+  G_END
+};
+
+const uint8_t fart3_song[] PROGMEM = {
+  G_BEND(1600, 4000, 1.02, 2, 20), G_SYNC(SYNC_SOUND),
+  G_BEND(4000, 3000, 1.02, 2, 20),
+  G_END
+};
+
+//-- Indexed by song number (see Pando_sounds.h)
+const uint8_t * const song_code[SONGS] PROGMEM = {
+  connection_song,
+  disconnection_song,
+  buttonPushed_song,
+  mode1_song,
+  mode2_song,
+  mode3_song,
+  surprise_song,
+  OhOoh_song,
+  OhOoh2_song,
+  cuddly_song,
+  sleeping_song,
+  happy_song,
+  superHappy_song,
+  happy_short_song,
+  sad_song,
+  confused_song,
+  fart1_song,
+  fart2_song,
+  fart3_song
+};
+
+//-- Indexed by gesture number (see Pando_gestures.h)
+const uint8_t * const gesture_code[GESTURES] PROGMEM = {
+  happy_code,
+  superhappy_code,
+  sad_code,
+  sleeping_code,
+  fart_code,
+  confused_code,
+  love_code,
+  angry_code,
+  fretful_code,
+  magic_code,
+  wave_code,
+  victory_code,
+  fail_code,
+  thinking_code
+};
+
+#endif
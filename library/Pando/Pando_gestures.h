@@ -20,6 +20,18 @@
 #define PandoFail 		12
 #define PandoThinking     13
 
+#define GESTURES          14
+
+//-- Priorities. A requested gesture preempts whatever runs with a lower one
+#define PRIORITY_IDLE       0   //-- Nothing running
+#define PRIORITY_LOW        1
+#define PRIORITY_NORMAL     2   //-- Default of gestures and motions
+#define PRIORITY_HIGH       3
+#define PRIORITY_URGENT     4
+
+//-- Time to blend the legs home when a gesture is preempted (ms)
+#define PREEMPT_BLEND       250
+
 //*** MOUTH ANIMATIONS***
 // #define littleUuh		0
 // #define dreamMouth		1 	
@@ -0,0 +1,316 @@
+//--------------------------------------------------------------
+//-- Pando gesture link
+//-- Receives gesture programs over a serial port, checks them
+//-- and plays them from RAM or keeps them on the EEPROM
+//--------------------------------------------------------------
+#include "Pando_link.h"
+
+//-- Parser states
+#define WAIT_SYNC_1   0
+#define WAIT_SYNC_2   1
+#define WAIT_COMMAND  2
+#define WAIT_LENGTH   3
+#define WAIT_PAYLOAD  4
+
+//-- Operand bytes of every opcode (see Pando_timeline.h)
+static const uint8_t op_operands[] PROGMEM = {
+  0,    //-- OP_END
+  3,    //-- OP_POSE
+  2,    //-- OP_HOME
+  6,    //-- OP_GAIT
+  1,    //-- OP_EYES
+  5,    //-- OP_TONE
+  7,    //-- OP_BEND
+  10,   //-- OP_BENDS
+  2,    //-- OP_WAIT
+  1,    //-- OP_SYNC
+  1,    //-- OP_LOOP
+  0,    //-- OP_NEXT
+  0     //-- OP_DETACH
+};
+
+//-- Only the bytes that change are written (the EEPROM wears out)
+static void writeEEPROM(int address, uint8_t data){
+
+  if (EEPROM.read(address) != data) EEPROM.write(address, data);
+}
+
+//-- Little endian word of a program, as Pando::_readWord() reads it
+static int16_t readWord(const uint8_t *code){
+
+  return (int16_t)(code[0] | (code[1] << 8));
+}
+
+//-- Gait, T and dir of an OP_GAIT. dir is FORWARD / BACKWARD or
+//-- LEFT / RIGHT for the gaits that go somewhere, 0 may do for the others
+static bool checkGait(uint8_t gait, int T, int8_t dir){
+
+  if (gait == GAIT_NONE || gait >= GAITS) return false;
+  if (T < GAIT_T_MIN || T > GAIT_T_MAX) return false;
+  if (dir < -1 || dir > 1) return false;
+
+  return dir != 0 || gait > GAIT_FLAPPING;
+}
+
+//-- Bend from f0 to f1, with prop the (prop-1)*1000 byte. A prop of 0
+//-- would step the bend by 1 Hz, one tone per Hz
+static bool checkBend(long f0, long f1, uint8_t prop){
+
+  return prop != 0 &&
+         f0 >= BEND_FREQ_MIN && f0 <= BEND_FREQ_MAX &&
+         f1 >= BEND_FREQ_MIN && f1 <= BEND_FREQ_MAX;
+}
+
+
+PandoLink::PandoLink(){
+
+  _port = NULL;
+  _pando = NULL;
+  _state = WAIT_SYNC_1;
+  _status = LINK_OK;
+}
+
+void PandoLink::begin(Stream &port, Pando &pando){
+
+  _port = &port;
+  _pando = &pando;
+  _state = WAIT_SYNC_1;
+}
+
+//-- CRC16-CCITT, one byte at a time (start with crc = 0xFFFF)
+uint16_t PandoLink::crc16(uint16_t crc, uint8_t data){
+
+  crc ^= (uint16_t)data << 8;
+  for (int i = 0; i < 8; i++)
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+
+  return crc;
+}
+
+//---------------------------------------------------------
+//-- Walk the program as the interpreter would, so that a bad
+//-- upload can not make it read past the buffer, jump to a
+//-- pose, gait or loop that does not exist, run a gait at a
+//-- period the oscillators can not sample or play a bend
+//-- that never ends
+//---------------------------------------------------------
+int PandoLink::checkProgram(const uint8_t *code, int size){
+
+  int depth = 0;
+
+  for (int i = 0; i < size; ) {
+    uint8_t op = code[i];
+    if (op >= sizeof(op_operands)) return 0;
+
+    int next = i + 1 + pgm_read_byte(&op_operands[op]);
+    if (next > size) return 0;
+
+    switch (op) {
+      case OP_END:
+        return depth == 0 ? next : 0;
+      case OP_POSE:
+        if (code[i+1] >= POSES) return 0;
+        break;
+      case OP_GAIT:
+        if (!checkGait(code[i+1], readWord(code+i+3), (int8_t)code[i+6])) return 0;
+        break;
+      case OP_BEND:
+        if (!checkBend(readWord(code+i+1), readWord(code+i+3), code[i+5])) return 0;
+        break;
+      case OP_BENDS: {
+        //-- The first and the last bend of the run bound all the others
+        if (code[i+7] == 0 || code[i+7] > BENDS_MAX) return 0;
+        long f = readWord(code+i+1);
+        long span = readWord(code+i+3);
+        long shift = (long)readWord(code+i+5) * (code[i+7] - 1);
+        if (!checkBend(f, f + span, code[i+8]) || !checkBend(f + shift, f + span + shift, code[i+8])) return 0;
+        break;
+      }
+      case OP_LOOP:
+        if (++depth > LOOP_DEPTH || code[i+1] == 0) return 0;
+        break;
+      case OP_NEXT:
+        if (--depth < 0) return 0;
+        break;
+    }
+    i = next;
+  }
+
+  return 0;   //-- No OP_END
+}
+
+void PandoLink::update(){
+
+  if (_port == NULL) return;
+
+  //-- A frame cut short is dropped
+  if (_state != WAIT_SYNC_1 && millis() - _time > LINK_TIMEOUT) _state = WAIT_SYNC_1;
+
+  while (_port->available() > 0) {
+    uint8_t data = _port->read();
+    _time = millis();
+
+    switch (_state) {
+      case WAIT_SYNC_1:
+        if (data == LINK_SYNC_1) _state = WAIT_SYNC_2;
+        break;
+
+      case WAIT_SYNC_2:
+        _state = data == LINK_SYNC_2 ? WAIT_COMMAND : WAIT_SYNC_1;
+        break;
+
+      case WAIT_COMMAND:
+        _command = data;
+        _state = WAIT_LENGTH;
+        break;
+
+      case WAIT_LENGTH:
+        if (data > LINK_PAYLOAD_MAX) {
+          _reply(LINK_BAD_LENGTH);
+          _state = WAIT_SYNC_1;
+          break;
+        }
+        _length = data;
+        _count = 0;
+        _state = WAIT_PAYLOAD;
+        break;
+
+      case WAIT_PAYLOAD:
+        _frame[_count++] = data;
+        if (_count == _length + 2) {
+          _state = WAIT_SYNC_1;
+          _run();
+        }
+        break;
+    }
+  }
+}
+
+//-- Check the CRC of the frame just received and run its command
+void PandoLink::_run(){
+
+  uint16_t crc = crc16(crc16(0xFFFF, _command), _length);
+  for (int i = 0; i < _length; i++) crc = crc16(crc, _frame[i]);
+
+  if (crc != (_frame[_length] | ((uint16_t)_frame[_length+1] << 8))) {
+    _reply(LINK_BAD_CRC);
+    return;
+  }
+
+  switch (_command) {
+
+    case LINK_PING: {
+      uint8_t info[3] = {LINK_VERSION, LINK_PROGRAM_MAX, LINK_SLOTS};
+      _reply(LINK_OK, info, sizeof(info));
+      return;
+    }
+
+    case LINK_PLAY:
+      if (_length < 2) break;
+      _reply(_play(_frame + 1, _length - 1, _frame[0]));
+      return;
+
+    case LINK_STORE:
+      if (_length < 2) break;
+      _reply(_store(_frame[0], _frame + 1, _length - 1));
+      return;
+
+    case LINK_PLAY_SLOT: {
+      if (_length != 2) break;
+      //-- Load the slot in the frame buffer: the running program stays whole
+      //-- until the new one is known to be good
+      int size;
+      uint8_t status = _load(_frame[0], &size);
+      if (status == LINK_OK) status = _play(_frame + 2, size, _frame[1]);
+      _reply(status);
+      return;
+    }
+
+    case LINK_STOP:
+      if (_length != 0) break;
+      _reply(LINK_OK);
+      _pando->stopGesture();
+      return;
+
+    default:
+      _reply(LINK_BAD_COMMAND);
+      return;
+  }
+
+  _reply(LINK_BAD_LENGTH);
+}
+
+void PandoLink::_reply(uint8_t status, const uint8_t *data, uint8_t size){
+
+  uint8_t head[4] = {LINK_ACK, (uint8_t)(size + 2), _command, status};
+  uint16_t crc = 0xFFFF;
+
+  _status = status;
+
+  _port->write(LINK_SYNC_1);
+  _port->write(LINK_SYNC_2);
+  for (int i = 0; i < 4; i++) {
+    _port->write(head[i]);
+    crc = crc16(crc, head[i]);
+  }
+  for (int i = 0; i < size; i++) {
+    _port->write(data[i]);
+    crc = crc16(crc, data[i]);
+  }
+  _port->write(crc & 0xFF);
+  _port->write(crc >> 8);
+}
+
+uint8_t PandoLink::_play(const uint8_t *code, int size, uint8_t priority){
+
+  size = checkProgram(code, size);
+  if (size == 0) return LINK_BAD_PROGRAM;
+
+  if (priority == PRIORITY_IDLE || priority > PRIORITY_URGENT) priority = PRIORITY_NORMAL;
+
+  memmove(_program, code, size);
+  _pando->startProgram(_program, priority, PROGRAM_RAM);
+
+  return LINK_OK;
+}
+
+uint8_t PandoLink::_store(uint8_t slot, const uint8_t *code, int size){
+
+  if (slot >= LINK_SLOTS) return LINK_BAD_SLOT;
+
+  size = checkProgram(code, size);
+  if (size == 0) return LINK_BAD_PROGRAM;
+
+  int address = LINK_EEPROM_START + slot * LINK_SLOT_SIZE;
+  uint16_t crc = 0xFFFF;
+
+  writeEEPROM(address, size);
+  for (int i = 0; i < size; i++) {
+    crc = crc16(crc, code[i]);
+    writeEEPROM(address + 1 + i, code[i]);
+  }
+  writeEEPROM(address + 1 + size, crc & 0xFF);
+  writeEEPROM(address + 2 + size, crc >> 8);
+
+  return LINK_OK;
+}
+
+//-- Copy a slot to the frame buffer, from _frame[2] on
+uint8_t PandoLink::_load(uint8_t slot, int *size){
+
+  if (slot >= LINK_SLOTS) return LINK_BAD_SLOT;
+
+  int address = LINK_EEPROM_START + slot * LINK_SLOT_SIZE;
+  uint16_t crc = 0xFFFF;
+
+  *size = EEPROM.read(address);
+  if (*size == 0 || *size > LINK_PROGRAM_MAX) return LINK_EMPTY_SLOT;
+
+  for (int i = 0; i < *size; i++) {
+    _frame[2 + i] = EEPROM.read(address + 1 + i);
+    crc = crc16(crc, _frame[2 + i]);
+  }
+  uint16_t stored = EEPROM.read(address + 1 + *size) | ((uint16_t)EEPROM.read(address + 2 + *size) << 8);
+
+  return crc == stored ? LINK_OK : LINK_EMPTY_SLOT;
+}
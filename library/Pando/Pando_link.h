@@ -0,0 +1,88 @@
+#ifndef Pando_link_h
+#define Pando_link_h
+
+#include "Pando.h"
+
+//***********************************************************************************
+//*********************************GESTURE LINK**************************************
+//***********************************************************************************
+//-- Serial protocol to upload gesture programs (see Pando_timeline.h) and play
+//-- them without reflashing. tools/pando_link.py is the host side.
+//-- Frame (both ways):
+//--   LINK_SYNC_1 LINK_SYNC_2 command length payload crc_low crc_high
+//-- The CRC is CRC16-CCITT (polynomial 0x1021, initial 0xFFFF) of command,
+//-- length and payload. Pando answers every frame with a LINK_ACK frame
+//-- (payload: command, status, data...)
+
+#define LINK_SYNC_1         0xA5
+#define LINK_SYNC_2         0x5A
+#define LINK_VERSION        1
+#define LINK_PAYLOAD_MAX    100
+#define LINK_PROGRAM_MAX    (LINK_PAYLOAD_MAX - 1)
+#define LINK_TIMEOUT        200   //-- Max gap between the bytes of a frame (ms)
+
+//-- Commands                     Payload
+#define LINK_PING           1   //-- Answer: version, LINK_PROGRAM_MAX, LINK_SLOTS
+#define LINK_PLAY           2   //-- priority (0: normal), program. Plays it from RAM
+#define LINK_STORE          3   //-- slot, program. Saves it on the EEPROM
+#define LINK_PLAY_SLOT      4   //-- slot, priority
+#define LINK_STOP           5   //--
+#define LINK_ACK            0x80
+
+//-- Status
+#define LINK_OK             0
+#define LINK_BAD_CRC        1
+#define LINK_BAD_LENGTH     2
+#define LINK_BAD_COMMAND    3
+#define LINK_BAD_PROGRAM    4   //-- Unknown opcode, operand out of range, no OP_END...
+#define LINK_BAD_SLOT       5
+#define LINK_EMPTY_SLOT     6   //-- Never stored, or its CRC does not match
+
+//-- EEPROM slots: length, program, CRC of the program. The trims use
+//-- the addresses 0 to 3
+#define LINK_EEPROM_START   32
+#define LINK_SLOTS          4
+#define LINK_SLOT_SIZE      (LINK_PROGRAM_MAX + 3)
+
+
+class PandoLink
+{
+  public:
+    PandoLink();
+
+    void begin(Stream &port, Pando &pando);
+
+    //-- Reads the port and runs the commands. Call it from loop(), with
+    //-- Pando.update(): a frame longer than the serial buffer (64 bytes)
+    //-- is lost if Pando is busy in a blocking motion
+    void update();
+
+    uint8_t getLastStatus() {return _status;};
+
+    static uint16_t crc16(uint16_t crc, uint8_t data);
+
+    //-- Length of a well formed program (up to its OP_END), 0 if it is not one
+    static int checkProgram(const uint8_t *code, int size);
+
+  private:
+    void _run();
+    void _reply(uint8_t status, const uint8_t *data=NULL, uint8_t size=0);
+    uint8_t _play(const uint8_t *code, int size, uint8_t priority);
+    uint8_t _store(uint8_t slot, const uint8_t *code, int size);
+    uint8_t _load(uint8_t slot, int *size);
+
+    Stream *_port;
+    Pando *_pando;
+
+    uint8_t _state;             //-- Frame byte expected next
+    uint8_t _command;
+    uint8_t _length;
+    uint8_t _count;             //-- Payload and CRC bytes received
+    unsigned long _time;        //-- Last byte received
+    uint8_t _status;
+    uint8_t _frame[LINK_PAYLOAD_MAX + 2];   //-- Payload and CRC
+
+    uint8_t _program[LINK_PROGRAM_MAX];     //-- The RAM program Pando plays
+};
+
+#endif
@@ -0,0 +1,118 @@
+//--------------------------------------------------------------
+//-- Pando odometry
+//-- Integrates a calibrated displacement per gait cycle into an
+//-- (x, y, heading) estimate. The heading comes from the gyro
+//-- yaw when there is one, from the calibration otherwise
+//--------------------------------------------------------------
+#include "Pando_odometry.h"
+#include <math.h>
+
+//-- Bring an angle (degrees) to the -180 to 180 range
+static double wrapAngle(double angle){
+
+  while (angle > 180) angle -= 360;
+  while (angle < -180) angle += 360;
+  return angle;
+}
+
+//-- Gaits whose dir is LEFT / RIGHT: dir mirrors them, but they keep
+//-- going forward (turn() always walks forward, on the other hip)
+static bool mirrored(int gait){
+
+  return gait == GAIT_TURN || gait == GAIT_MOONWALKER || gait == GAIT_CRUSAITO;
+}
+
+
+Odometry::Odometry(){
+
+  //-- Rough values for a standard Pando on a hard floor.
+  //-- Measure your own robot and use calibrate()
+  for (int i = 0; i < GAITS; i++) calibrate(i, 0, 0, 0);
+  calibrate(GAIT_WALK,       30,  0,  0);
+  calibrate(GAIT_TURN,       10,  0, 12);
+  calibrate(GAIT_MOONWALKER,  0, 15,  0);
+  calibrate(GAIT_CRUSAITO,    0, 20,  0);
+  calibrate(GAIT_FLAPPING,   15,  0,  0);
+
+  for (int i = 0; i < GAITS; i++) _cycles[i] = 0;
+  _distance = 0;
+  _heading = 0;
+  _yaw0 = 0;
+  reset();
+}
+
+//---------------------------------------------------------
+//-- Set the current pose (mm, degrees). The distance
+//-- travelled and the cycle counters are kept
+//---------------------------------------------------------
+void Odometry::reset(double x, double y, double heading){
+
+  _yaw0 += _heading - heading;
+  _x = x;
+  _y = y;
+  _heading = heading;
+}
+
+//-- Tell which gyro yaw corresponds to the current heading
+void Odometry::setYawReference(double yaw){
+
+  _yaw0 = yaw - _heading;
+}
+
+//---------------------------------------------------------
+//-- Displacement of one cycle of a gait, walking with dir = 1
+//--  Parameters:
+//--    forward, lateral: mm (lateral is positive to the left)
+//--    turn: degrees (positive to the left)
+//---------------------------------------------------------
+void Odometry::calibrate(int gait, int forward, int lateral, int turn){
+
+  if (gait < 0 || gait >= GAITS) return;
+
+  _steps[gait].forward = forward;
+  _steps[gait].lateral = lateral;
+  _steps[gait].turn = turn;
+}
+
+//-- Cycles done without a gyro: the heading comes from the calibration
+void Odometry::addCycles(int gait, int dir, float cycles){
+
+  if (gait < 0 || gait >= GAITS) return;
+
+  move(gait, dir, cycles, _heading + _steps[gait].turn * dir * cycles);
+}
+
+//-- Cycles done with a gyro: yaw is Gyro::getAngleZ at the end of them
+void Odometry::addCycles(int gait, int dir, float cycles, double yaw){
+
+  if (gait < 0 || gait >= GAITS) return;
+
+  move(gait, dir, cycles, yaw - _yaw0);
+}
+
+void Odometry::move(int gait, int dir, float cycles, double heading){
+
+  //-- Assume the heading changed evenly along the cycles
+  double mid = (_heading + wrapAngle(heading - _heading) / 2) * M_PI / 180;
+
+  double forward = (double)_steps[gait].forward * (mirrored(gait) ? 1 : dir) * cycles;
+  double lateral = (double)_steps[gait].lateral * dir * cycles;
+
+  _x += forward * cos(mid) - lateral * sin(mid);
+  _y += forward * sin(mid) + lateral * cos(mid);
+  _distance += sqrt(forward * forward + lateral * lateral);
+  _heading = wrapAngle(heading);
+  _cycles[gait] += cycles;
+}
+
+//-- Distance (mm) from the current position to a point
+double Odometry::distanceTo(double x, double y){
+
+  return sqrt((x - _x) * (x - _x) + (y - _y) * (y - _y));
+}
+
+//-- Turn (degrees, positive to the left) that faces the robot to a point
+double Odometry::bearingTo(double x, double y){
+
+  return wrapAngle(atan2(y - _y, x - _x) * 180 / M_PI - _heading);
+}
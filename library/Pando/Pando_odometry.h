@@ -0,0 +1,49 @@
+#ifndef Pando_odometry_h
+#define Pando_odometry_h
+
+#include "Pando_gaits.h"
+
+//-- Displacement of one gait cycle with dir = 1 (FORWARD / LEFT).
+//-- dir = -1 reverses all of it, but for the LEFT / RIGHT gaits
+//-- (turn, moonwalker, crusaito) that keep the forward part
+struct GaitStep {
+  int forward;    //-- mm
+  int lateral;    //-- mm, positive to the left
+  int turn;       //-- degrees, positive to the left
+};
+
+//-- Dead reckoning of the robot pose from the gait cycles it has done
+class Odometry
+{
+  public:
+    Odometry();
+
+    void reset(double x=0, double y=0, double heading=0);
+    void setYawReference(double yaw);
+    void calibrate(int gait, int forward, int lateral, int turn);
+
+    void addCycles(int gait, int dir, float cycles);
+    void addCycles(int gait, int dir, float cycles, double yaw);
+
+    double getX() {return _x;};
+    double getY() {return _y;};
+    double getHeading() {return _heading;};
+    double getDistance() {return _distance;};
+    float getCycles(int gait) {return _cycles[gait];};
+
+    double distanceTo(double x, double y);
+    double bearingTo(double x, double y);
+
+  private:
+    void move(int gait, int dir, float cycles, double heading);
+
+    GaitStep _steps[GAITS];
+    float _cycles[GAITS];   //-- Cycles done by each gait
+
+    double _x, _y;          //-- Position (mm)
+    double _heading;        //-- Degrees, -180 to 180
+    double _distance;       //-- Total distance travelled (mm)
+    double _yaw0;           //-- Gyro yaw when the heading was 0
+};
+
+#endif
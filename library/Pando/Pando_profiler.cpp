@@ -0,0 +1,104 @@
+//--------------------------------------------------------------
+//-- Pando motion profiler
+//-- Compares the planned duration of every move with the real one
+//-- and keeps the last PROFILER_RECORDS moves in a ring buffer
+//--------------------------------------------------------------
+#include "Pando_profiler.h"
+
+#ifdef PANDO_PROFILER
+
+
+void Profiler::clear(){
+
+  head = 0;
+  count = 0;
+  depth = 0;
+}
+
+//---------------------------------------------------------
+//-- Start a new record
+//--  Parameters:
+//--    kind: PROF_EXECUTE, PROF_MOVE...
+//--    planned: planned duration (ms)
+//--    period: expected time between ticks (ms), 0 if the motion has no ticks
+//---------------------------------------------------------
+void Profiler::begin(uint8_t kind, unsigned long planned, unsigned int period){
+
+  if (depth++ >= PROFILER_DEPTH) return;  //-- Too deep, this one is not tracked
+
+  ProfileRecord &r = records[head];
+  r.kind = kind;
+  r.planned = planned;
+  r.actual = 0;
+  r.ticks = 0;
+  r.planned_ticks = period ? min(planned / period, 0xFFFFUL) : 0;
+  r.max_gap = 0;
+  r.overruns = 0;
+
+  Active &a = active[depth-1];
+  a.record = head;
+  a.period = period;
+  a.start = millis();
+  a.last = a.start;
+
+  head = (head + 1) % PROFILER_RECORDS;
+  if (count < PROFILER_RECORDS) count++;
+}
+
+//-- One tick of the innermost motion. It also counts for the motions around it
+void Profiler::tick(){
+
+  unsigned long now = millis();
+  uint8_t n = min(depth, PROFILER_DEPTH);
+
+  for (uint8_t i = 0; i < n; i++) {
+    ProfileRecord &r = records[active[i].record];
+    unsigned long gap = now - active[i].last;
+
+    if (gap > r.max_gap) r.max_gap = min(gap, 0xFFFFUL);
+    if (active[i].period && gap > active[i].period && r.overruns < 0xFF) r.overruns++;
+    if (r.ticks < 0xFFFF) r.ticks++;
+    active[i].last = now;
+  }
+}
+
+void Profiler::end(){
+
+  if (depth == 0) return;
+  if (depth-- > PROFILER_DEPTH) return;
+
+  Active &a = active[depth];
+  records[a.record].actual = millis() - a.start;
+}
+
+//-- Print the records, oldest first
+void Profiler::dump(Print &out){
+
+  out.println(F("kind      planned actual ticks/planned max_gap overruns"));
+
+  uint8_t first = (head + PROFILER_RECORDS - count) % PROFILER_RECORDS;
+  for (uint8_t i = 0; i < count; i++) {
+    ProfileRecord &r = records[(first + i) % PROFILER_RECORDS];
+
+    switch (r.kind) {
+      case PROF_EXECUTE:    out.print(F("execute   ")); break;
+      case PROF_MOVE:       out.print(F("move      ")); break;
+      case PROF_OSCILLATE:  out.print(F("oscillate ")); break;
+      case PROF_BEND:       out.print(F("bend      ")); break;
+      default:              out.print(F("?         ")); break;
+    }
+    out.print(r.planned);
+    out.print('\t');
+    out.print(r.actual);
+    out.print('\t');
+    out.print(r.ticks);
+    out.print('/');
+    out.print(r.planned_ticks);
+    out.print('\t');
+    out.print(r.max_gap);
+    out.print('\t');
+    out.println(r.overruns);
+  }
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef Pando_profiler_h
+#define Pando_profiler_h
+
+#include "Pando_config.h"
+
+//-- Profiled motions
+#define PROF_EXECUTE        0
+#define PROF_MOVE           1
+#define PROF_OSCILLATE      2
+#define PROF_BEND           3
+
+//-- Nested motions tracked at the same time (bend -> _moveServos)
+#define PROFILER_DEPTH      3
+
+
+#ifdef PANDO_PROFILER
+
+#if defined(ARDUINO) && ARDUINO >= 100
+  #include "Arduino.h"
+#else
+  #include "WProgram.h"
+#endif
+
+//-- One finished (or running) motion
+struct ProfileRecord {
+  uint8_t  kind;
+  uint8_t  overruns;        //-- Ticks that came later than their period (saturates)
+  uint32_t planned;         //-- Planned duration (ms)
+  uint32_t actual;          //-- Measured duration (ms)
+  uint16_t ticks;           //-- Ticks actually run (saturates at 65535)
+  uint16_t planned_ticks;   //-- Ticks the planned duration should take (idem)
+  uint16_t max_gap;         //-- Longest time between two ticks (ms, idem)
+};
+
+class Profiler
+{
+  public:
+    Profiler() {clear();};
+
+    void begin(uint8_t kind, unsigned long planned, unsigned int period);
+    void tick();
+    void end();
+
+    void clear();
+    void dump(Print &out);
+
+  private:
+    //-- Motions that have begun but not ended yet
+    struct Active {
+      uint8_t record;
+      uint8_t period;
+      unsigned long start;
+      unsigned long last;
+    };
+
+    ProfileRecord records[PROFILER_RECORDS];
+    Active active[PROFILER_DEPTH];
+    uint8_t head;       //-- Next record to write
+    uint8_t count;      //-- Records stored
+    uint8_t depth;      //-- Motions running (may exceed PROFILER_DEPTH)
+};
+
+  #define PROFILE_BEGIN(kind, planned, period)  profiler.begin(kind, planned, period)
+  #define PROFILE_TICK()                        profiler.tick()
+  #define PROFILE_END()                         profiler.end()
+
+#else
+
+  #define PROFILE_BEGIN(kind, planned, period)  do {} while (0)
+  #define PROFILE_TICK()                        do {} while (0)
+  #define PROFILE_END()                         do {} while (0)
+
+#endif
+
+#endif
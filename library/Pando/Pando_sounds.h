@@ -130,4 +130,6 @@
 #define S_fart2			17
 #define S_fart3			18
 
+#define SONGS			19
+
 #endif
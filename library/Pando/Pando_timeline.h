@@ -0,0 +1,103 @@
+#ifndef Pando_timeline_h
+#define Pando_timeline_h
+
+#include <stdint.h>
+
+//***********************************************************************************
+//*********************************GESTURE TIMELINES*********************************
+//***********************************************************************************
+//-- A gesture is a small bytecode program stored in PROGMEM. It drives
+//-- three tracks that run at the same time:
+//--   servos: poses and gaits (a new one replaces the running one)
+//--   eyes:   expressions (instant)
+//--   sound:  tones and bends (a new one replaces the running one)
+//-- Starting a pose, gait or sound does not wait for it: the program goes on
+//-- at once, until an OP_WAIT or an OP_SYNC. Multi byte values are little endian
+
+//-- Opcodes                      Operands (bytes)
+#define OP_END      0   //--
+#define OP_POSE     1   //-- pose (POSE_*), time (2)
+#define OP_HOME     2   //-- time (2). Detaches the servos at the end
+#define OP_GAIT     3   //-- gait (GAIT_*), steps*10, T (2), h, dir
+#define OP_EYES     4   //-- eye expression
+#define OP_TONE     5   //-- frequency (2), duration (2), silence
+#define OP_BEND     6   //-- initial frequency (2), final frequency (2),
+                        //-- (prop-1)*1000, note duration, silence
+#define OP_BENDS    7   //-- Run of bends from f to f+span, f growing by step:
+                        //-- f (2), span (2), step (2), count, (prop-1)*1000,
+                        //-- note duration, silence
+#define OP_WAIT     8   //-- time (2)
+#define OP_SYNC     9   //-- tracks to wait for (SYNC_*)
+#define OP_LOOP     10  //-- count. Runs up to OP_NEXT count times
+#define OP_NEXT     11  //--
+#define OP_DETACH   12  //-- Servos off (Pando falls limp)
+
+//-- OP_SYNC tracks
+#define SYNC_SERVOS 1
+#define SYNC_SOUND  2
+#define SYNC_ALL    3
+
+//-- Nested OP_LOOPs
+#define LOOP_DEPTH  2
+
+//-- Gait periods an uploaded program may use (see PandoLink::checkProgram).
+//-- The oscillators sample every 30 ms: a cycle needs two samples
+#define GAIT_T_MIN    60
+#define GAIT_T_MAX    10000
+
+//-- Bends an uploaded program may play (see PandoLink::checkProgram)
+#define BEND_FREQ_MIN 31      //-- Lowest tone() of the AVR (Hz)
+#define BEND_FREQ_MAX 20000
+#define BENDS_MAX     64      //-- Bends of an OP_BENDS run
+
+//-- Where the program is (see Pando::startProgram)
+#define PROGRAM_FLASH 0
+#define PROGRAM_RAM   1
+
+//-- Tracks
+#define TRACK_IDLE  0
+#define TRACK_POSE  1
+#define TRACK_GAIT  2
+#define TRACK_TONE  3
+#define TRACK_BEND  4
+
+//-- Gesture poses (see gesture_poses[] in Pando.cpp)
+#define POSE_SAD          0
+#define POSE_BED          1
+#define POSE_FART_1       2
+#define POSE_FART_2       3
+#define POSE_FART_3       4
+#define POSE_CONFUSED     5
+#define POSE_ANGRY        6
+#define POSE_HEAD_LEFT    7
+#define POSE_HEAD_RIGHT   8
+#define POSE_FRETFUL      9
+#define POSE_BEND_1       10
+#define POSE_BEND_2       11
+#define POSE_BEND_3       12
+#define POSE_BEND_4       13
+#define POSE_VICTORY      14
+#define POSE_STAND        15    //-- Home, with the servos on
+
+#define POSES             16
+
+//-- Helpers to write the programs
+#define G_WORD(w)                           (uint8_t)((int)(w) & 0xFF), (uint8_t)(((int)(w) >> 8) & 0xFF)
+#define G_PROP(prop)                        (uint8_t)(((prop) - 1) * 1000 + 0.5)
+
+#define G_END                               OP_END
+#define G_POSE(pose, time)                  OP_POSE, pose, G_WORD(time)
+#define G_HOME                              OP_HOME, G_WORD(500)
+#define G_GAIT(gait, steps, T, h, dir)      OP_GAIT, gait, (uint8_t)((steps)*10), G_WORD(T), (uint8_t)(h), (uint8_t)(dir)
+#define G_EYES(expression)                  OP_EYES, expression
+#define G_TONE(freq, duration, silence)     OP_TONE, G_WORD(freq), G_WORD(duration), silence
+#define G_BEND(f0, f1, prop, note, silence) OP_BEND, G_WORD(f0), G_WORD(f1), G_PROP(prop), note, silence
+#define G_BENDS(f, span, step, count, prop, note, silence) \
+          OP_BENDS, G_WORD(f), G_WORD(span), G_WORD(step), count, G_PROP(prop), note, silence
+#define G_WAIT(time)                        OP_WAIT, G_WORD(time)
+#define G_SYNC(tracks)                      OP_SYNC, tracks
+#define G_LOOP(count)                       OP_LOOP, count
+#define G_NEXT                              OP_NEXT
+#define G_DETACH                            OP_DETACH
+
+#endif
@@ -0,0 +1,151 @@
+//--------------------------------------------------------------
+//-- Pando motion watchdog
+//-- Makes the servos safe when the motion tick is not serviced
+//--------------------------------------------------------------
+#include "Pando_watchdog.h"
+
+#ifdef PANDO_WATCHDOG
+
+#if defined(__AVR__)
+  #include <avr/wdt.h>
+  #include <avr/interrupt.h>
+
+  //-- Nearest hardware timeout not shorter than WATCHDOG_TIMEOUT
+  #if WATCHDOG_TIMEOUT <= 15
+    #define WATCHDOG_WDTO WDTO_15MS
+    #define WATCHDOG_PERIOD 15
+  #elif WATCHDOG_TIMEOUT <= 30
+    #define WATCHDOG_WDTO WDTO_30MS
+    #define WATCHDOG_PERIOD 30
+  #elif WATCHDOG_TIMEOUT <= 60
+    #define WATCHDOG_WDTO WDTO_60MS
+    #define WATCHDOG_PERIOD 60
+  #elif WATCHDOG_TIMEOUT <= 120
+    #define WATCHDOG_WDTO WDTO_120MS
+    #define WATCHDOG_PERIOD 120
+  #elif WATCHDOG_TIMEOUT <= 250
+    #define WATCHDOG_WDTO WDTO_250MS
+    #define WATCHDOG_PERIOD 250
+  #elif WATCHDOG_TIMEOUT <= 500
+    #define WATCHDOG_WDTO WDTO_500MS
+    #define WATCHDOG_PERIOD 500
+  #elif WATCHDOG_TIMEOUT <= 1000
+    #define WATCHDOG_WDTO WDTO_1S
+    #define WATCHDOG_PERIOD 1000
+  #else
+    #define WATCHDOG_WDTO WDTO_2S
+    #define WATCHDOG_PERIOD 2000
+  #endif
+
+  //-- The idle timeout is counted in hardware periods
+  #define WATCHDOG_IDLE_PERIODS \
+    ((WATCHDOG_IDLE_TIMEOUT + WATCHDOG_PERIOD - 1) / WATCHDOG_PERIOD > 255 ? 255 : \
+     (WATCHDOG_IDLE_TIMEOUT + WATCHDOG_PERIOD - 1) / WATCHDOG_PERIOD)
+#endif
+
+void (*Watchdog::_expire)(void) = NULL;
+volatile bool Watchdog::_armed = false;
+volatile bool Watchdog::_tripped = false;
+volatile bool Watchdog::_idle = false;
+#if defined(__AVR__)
+volatile uint8_t Watchdog::_periods = 0;
+#else
+volatile unsigned long Watchdog::_kicked = 0;
+#endif
+
+
+//-- Function called (once per arming) when the tick stops
+void Watchdog::begin(void (*expire)(void)){
+
+  _expire = expire;
+}
+
+//-- The servos hold torque from now on
+void Watchdog::arm(){
+
+  if (_armed) return;
+  _tripped = false;
+
+#if defined(__AVR__)
+  uint8_t sreg = SREG;
+  cli();
+  wdt_reset();
+  _periods = 0;
+  //-- Interrupt mode only: the sketch keeps running, nothing is reset
+  WDTCSR = _BV(WDCE) | _BV(WDE);
+  WDTCSR = _BV(WDIE) | ((WATCHDOG_WDTO & 0x08) ? _BV(WDP3) : 0) | (WATCHDOG_WDTO & 0x07);
+  SREG = sreg;
+#else
+  _kicked = millis();
+#endif
+
+  _armed = true;
+}
+
+void Watchdog::disarm(){
+
+  if (!_armed) return;
+  _armed = false;
+
+#if defined(__AVR__)
+  uint8_t sreg = SREG;
+  cli();
+  wdt_reset();
+  MCUSR &= ~_BV(WDRF);
+  WDTCSR = _BV(WDCE) | _BV(WDE);
+  WDTCSR = 0;
+  SREG = sreg;
+#endif
+}
+
+//-- The motion tick has been serviced
+void Watchdog::kick(){
+
+#if defined(__AVR__)
+  uint8_t sreg = SREG;
+  cli();
+  wdt_reset();
+  _periods = 0;
+  SREG = sreg;
+#else
+  _kicked = millis();
+#endif
+}
+
+//-- Idle: no motion runs, the servos only hold a pose. The sketch may
+//-- then go WATCHDOG_IDLE_TIMEOUT ms without a tick (a delay() between
+//-- two motions), but not forever (a sketch stuck in Serial.read())
+void Watchdog::setIdle(bool idle){
+
+  _idle = idle;
+  kick();
+}
+
+//-- Simulated watchdog check (does nothing with the hardware one)
+void Watchdog::poll(){
+
+#if !defined(__AVR__)
+  if (_armed && millis() - _kicked > (_idle ? WATCHDOG_IDLE_TIMEOUT : WATCHDOG_TIMEOUT)) expired();
+#endif
+}
+
+void Watchdog::expired(){
+
+  if (!_armed || _tripped) return;
+#if defined(__AVR__)
+  //-- The interrupt comes every hardware period
+  if (++_periods < (_idle ? WATCHDOG_IDLE_PERIODS : 1)) return;
+#endif
+  _tripped = true;
+  if (_expire != NULL) _expire();
+}
+
+
+#if defined(__AVR__)
+ISR(WDT_vect)
+{
+  Watchdog::expired();
+}
+#endif
+
+#endif
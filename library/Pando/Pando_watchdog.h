@@ -0,0 +1,58 @@
+#ifndef Pando_watchdog_h
+#define Pando_watchdog_h
+
+#include "Pando_config.h"
+
+#if defined(ARDUINO) && ARDUINO >= 100
+  #include "Arduino.h"
+#else
+  #include "WProgram.h"
+#endif
+
+//-- What Pando was doing when the motion tick stopped
+struct WatchdogEvent {
+  unsigned long time;   //-- millis() of the trip
+  uint8_t motion;       //-- GAIT_* / MOVE_* id
+  int8_t gesture;       //-- Gesture being played, -1 if none
+  uint8_t count;        //-- Trips since power on
+};
+
+
+#ifdef PANDO_WATCHDOG
+
+//---------------------------------------------------------
+//-- Motion watchdog. While armed it must be kicked at least every
+//-- WATCHDOG_TIMEOUT ms (WATCHDOG_IDLE_TIMEOUT ms while idle), or
+//-- the expire function is called once. On AVR it is the hardware
+//-- watchdog in interrupt mode (the function runs in the ISR).
+//-- Elsewhere it is simulated, and poll() has to be called from a
+//-- timer or a thread.
+//---------------------------------------------------------
+class Watchdog
+{
+  public:
+    static void begin(void (*expire)(void));
+    static void arm();
+    static void disarm();
+    static void kick();
+    static void setIdle(bool idle);
+    static void poll();
+    static bool isArmed() {return _armed;};
+
+    static void expired();
+
+  private:
+    static void (*_expire)(void);
+    static volatile bool _armed;
+    static volatile bool _tripped;
+    static volatile bool _idle;
+#if defined(__AVR__)
+    static volatile uint8_t _periods;   //-- Hardware periods since the last kick
+#else
+    static volatile unsigned long _kicked;
+#endif
+};
+
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+//--------------------------------------------------------------
+//-- Replays a sensor trace through the Pando behavior layer, to
+//-- tune it on the computer (see Pando_behavior.h)
+//--
+//-- Build and run:
+//--   g++ -I library/Pando -o behavior_replay tools/behavior_replay.cpp library/Pando/Pando_behavior.cpp
+//--   ./behavior_replay tools/traces/pet_and_drop.csv [-v]
+//--
+//-- Trace: one sample per line, "ms,touch,noise,pitch,roll", as printed by
+//-- Pando_sensor_test with RECORD_TRACE. Other lines are skipped. Lines can
+//-- be sparse: a sample holds until the next one.
+//-- -v prints the emotions at every period, not only at the decisions
+//--------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "Pando_behavior.h"
+
+struct TraceLine {
+  unsigned long time;
+  SensorSample sample;
+};
+
+static const char *gesture_names[GESTURES] = {
+  "Happy", "SuperHappy", "Sad", "Sleeping", "Fart", "Confused", "Love",
+  "Angry", "Fretful", "Magic", "Wave", "Victory", "Fail", "Thinking"
+};
+
+//-- Length of every gesture on a real Pando (ms), to know when it is busy
+static const unsigned long gesture_time[GESTURES] = {
+  1390, 1540, 4250, 10060, 7420, 1750, 3510, 2780, 3930, 4870, 7430, 3430, 4510, 3350
+};
+
+static void printEmotions(Behavior &behavior){
+
+  static const char *names[EMOTIONS] = {"joy", "affection", "fear", "anger", "boredom"};
+  for (int i = 0; i < EMOTIONS; i++) printf(" %s %3d", names[i], behavior.getEmotion(i));
+}
+
+int main(int argc, char *argv[]){
+
+  const char *path = NULL;
+  bool verbose = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0) verbose = true;
+    else path = argv[i];
+  }
+
+  FILE *file = path ? fopen(path, "r") : stdin;
+  if (file == NULL) {
+    fprintf(stderr, "can not open %s\n", path);
+    return 1;
+  }
+
+  std::vector<TraceLine> trace;
+  char text[128];
+  while (fgets(text, sizeof(text), file)) {
+    TraceLine line;
+    int touch;
+    if (sscanf(text, "%lu,%d,%d,%f,%f", &line.time, &touch, &line.sample.noise,
+               &line.sample.pitch, &line.sample.roll) != 5) continue;
+    line.sample.touch = touch != 0;
+    trace.push_back(line);
+  }
+  if (trace.empty()) {
+    fprintf(stderr, "no samples\n");
+    return 1;
+  }
+
+  Behavior behavior;
+  uint8_t running = PRIORITY_IDLE;
+  unsigned long busy_until = 0;
+  int decisions = 0;
+  size_t next = 0;
+  SensorSample sample = trace[0].sample;
+
+  //-- Start one period in: a time of 0 is the first update
+  unsigned long start = trace[0].time + BEHAVIOR_PERIOD;
+  for (unsigned long now = start; now <= trace.back().time + BEHAVIOR_PERIOD; now += BEHAVIOR_PERIOD) {
+    while (next < trace.size() && trace[next].time <= now) sample = trace[next++].sample;
+    if (now >= busy_until) running = PRIORITY_IDLE;
+
+    int8_t gesture = behavior.update(sample, now, running);
+
+    if (gesture >= 0) {
+      running = behavior.getPriority();
+      busy_until = now + gesture_time[gesture];
+      decisions++;
+      printf("%7lu  %-10s priority %d  events %02x ", now, gesture_names[gesture], running, behavior.getEvents());
+      printEmotions(behavior);
+      printf("\n");
+    }
+    else if (verbose) {
+      printf("%7lu  %-10s            events %02x ", now, running ? "(busy)" : "", behavior.getEvents());
+      printEmotions(behavior);
+      printf("\n");
+    }
+  }
+
+  printf("%d gestures in %.1f s\n", decisions, (trace.back().time - trace[0].time) / 1000.0);
+  return 0;
+}
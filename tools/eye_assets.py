@@ -0,0 +1,310 @@
+#!/usr/bin/env python3
+"""Compile eye art into the frame table of the Pando library (see Pando_eyes.h).
+
+    eye_assets.py tools/eyes/expressions.txt -o library/Pando/Pando_eye_frames.h
+    eye_assets.py art.txt                   (only the flash report)
+
+The art is a text file, '#' starts a comment. An asset groups frames, and
+frames are either drawn in the file or cut from a PNG:
+
+    asset blink
+    frame open                  # 8 rows of 24 columns, '#' or 'X' lit
+    ........................
+    ....###.........###.....
+    ...
+    png blink.png half closed   # 24x8 frames, left to right (next to the art)
+
+A PNG pixel is lit when it is bright and opaque. Every frame gets a
+FRAME_<NAME> define. Identical frames are stored once, so two names can
+share an index. Columns 0-11 hold the left eye, 12-23 the right one, and
+every eye is stored once: a frame only gives the shape of each eye, its
+column and if it is drawn mirrored. The report gives the flash every
+asset adds.
+
+Only the standard library is needed: the PNGs are read with zlib.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+WIDTH = 24
+HEIGHT = 8
+LIT = '#X'
+UNLIT = '.'
+
+#-- Eye storage, as in Pando_eyes.h
+SHAPE_SIZE = 8
+LAYOUT_SIZE = 4
+MIRROR = 0x80
+NO_SHAPE = 0x7F
+
+
+def symbol(name):
+    """happyOpen -> HAPPY_OPEN"""
+    return re.sub(r'(?<=[a-z0-9])(?=[A-Z])', '_', name).upper()
+
+
+def read_png(path):
+    """Pixels of a PNG as rows of booleans (lit or not)."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise ValueError('%s: not a PNG' % path)
+
+    chunks = {}
+    idat = b''
+    pos = 8
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        if kind == b'IDAT':
+            idat += body
+        else:
+            chunks[kind] = body
+        pos += 12 + length
+
+    width, height, depth, color, _, _, interlace = struct.unpack('>IIBBBBB', chunks[b'IHDR'])
+    if interlace:
+        raise ValueError('%s: interlaced PNGs are not supported' % path)
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color]
+    if depth != 8 and color not in (0, 3):
+        raise ValueError('%s: %d bit color is not supported' % (path, depth))
+
+    bits = depth * channels
+    stride = (width * bits + 7) // 8
+    step = max(1, bits // 8)
+    raw = zlib.decompress(idat)
+
+    #-- Undo the filters of every row
+    rows = []
+    previous = bytearray(stride)
+    for y in range(height):
+        start = y * (stride + 1)
+        kind = raw[start]
+        row = bytearray(raw[start + 1:start + 1 + stride])
+        for i in range(stride):
+            left = row[i - step] if i >= step else 0
+            up = previous[i]
+            corner = previous[i - step] if i >= step else 0
+            if kind == 1:
+                row[i] = (row[i] + left) & 0xFF
+            elif kind == 2:
+                row[i] = (row[i] + up) & 0xFF
+            elif kind == 3:
+                row[i] = (row[i] + (left + up) // 2) & 0xFF
+            elif kind == 4:
+                p = left + up - corner
+                pa, pb, pc = abs(p - left), abs(p - up), abs(p - corner)
+                row[i] = (row[i] + (left if pa <= pb and pa <= pc else (up if pb <= pc else corner))) & 0xFF
+        rows.append(row)
+        previous = row
+
+    palette = chunks.get(b'PLTE', b'')
+    alpha = chunks.get(b'tRNS', b'')
+    pixels = []
+    for row in rows:
+        line = []
+        for x in range(width):
+            if depth < 8:
+                sample = (row[x * depth // 8] >> (8 - depth - (x * depth) % 8)) & ((1 << depth) - 1)
+            else:
+                sample = row[x * channels]
+            if color == 3:
+                r, g, b = palette[3 * sample:3 * sample + 3]
+                a = alpha[sample] if sample < len(alpha) else 255
+            elif color == 0:
+                r = g = b = sample * 255 // ((1 << depth) - 1)
+                a = 255
+            else:
+                r, g, b = row[x * channels:x * channels + 3] if channels >= 3 else (sample,) * 3
+                a = row[x * channels + channels - 1] if color in (4, 6) else 255
+            line.append(a >= 128 and (r * 299 + g * 587 + b * 114) // 1000 >= 128)
+        pixels.append(line)
+    return pixels
+
+
+def columns(rows):
+    """Rows of booleans -> column bytes, bit 7 the top row."""
+    return bytes(sum(0x80 >> y for y in range(HEIGHT) if rows[y][x]) for x in range(WIDTH))
+
+
+def parse(path):
+    """Assets of an art file: [(asset, [(frame name, column bytes)])]."""
+    assets = []
+    folder = os.path.dirname(path)
+    with open(path) as f:
+        lines = [line.split('#', 1)[0].rstrip() if not set(line.strip()) <= set(LIT + UNLIT) else line.rstrip()
+                 for line in f]
+
+    def fail(number, message):
+        raise ValueError('%s:%d: %s' % (path, number + 1, message))
+
+    number = 0
+    while number < len(lines):
+        words = lines[number].split()
+        if not words:
+            number += 1
+            continue
+
+        if words[0] == 'asset' and len(words) == 2:
+            assets.append((words[1], []))
+        elif not assets:
+            fail(number, 'a frame before any asset')
+        elif words[0] == 'frame' and len(words) == 2:
+            art = lines[number + 1:number + 1 + HEIGHT]
+            if len(art) < HEIGHT:
+                fail(number, 'frame %s needs %d rows' % (words[1], HEIGHT))
+            for i, row in enumerate(art):
+                if len(row) != WIDTH or not set(row) <= set(LIT + UNLIT):
+                    fail(number + 1 + i, 'rows are %d columns of %s or %s' % (WIDTH, UNLIT, ' '.join(LIT)))
+            assets[-1][1].append((words[1], columns([[c in LIT for c in row] for row in art])))
+            number += HEIGHT
+        elif words[0] == 'png' and len(words) >= 3:
+            pixels = read_png(os.path.join(folder, words[1]))
+            if len(pixels) < HEIGHT or len(pixels[0]) < WIDTH * len(words[2:]):
+                fail(number, '%s is smaller than %d frames' % (words[1], len(words[2:])))
+            for i, name in enumerate(words[2:]):
+                cut = [line[i * WIDTH:(i + 1) * WIDTH] for line in pixels[:HEIGHT]]
+                assets[-1][1].append((name, columns(cut)))
+        else:
+            fail(number, 'expected asset, frame or png')
+        number += 1
+
+    return assets
+
+
+def split_eyes(data, shapes):
+    """Layout of a frame: shape and column of each eye. New shapes go to shapes."""
+    layout = []
+    for half in (0, WIDTH // 2):
+        lit = [x for x in range(half, half + WIDTH // 2) if data[x]]
+        if not lit:
+            layout += [NO_SHAPE, 0]
+            continue
+        content = bytes(data[lit[0]:lit[-1] + 1])
+        if len(content) > SHAPE_SIZE:
+            raise ValueError('an eye of %d columns, more than %d' % (len(content), SHAPE_SIZE))
+
+        #-- The same eye, or the same drawn right to left
+        mirror = bytes(reversed(content))
+        column = lit[0] - (SHAPE_SIZE - len(content))
+        if content not in shapes and mirror in shapes and column >= 0:
+            layout += [shapes[mirror] | MIRROR, column]
+            continue
+        if content not in shapes:
+            shapes[content] = len(shapes)
+        layout += [shapes[content], lit[0]]
+    return tuple(layout)
+
+
+def compile_assets(assets):
+    """Frames without duplicates, eyes stored once:
+    (layouts, shapes, defines, report lines)."""
+    layouts = []        #-- (layout, first name)
+    index = {}
+    shapes = {}         #-- Eye columns -> shape number
+    defines = []
+    report = []
+    names = set()
+
+    def line(asset, frames, stored, added_shapes):
+        return '%-16s %3d frames  %3d stored  %3d eyes  %5d bytes' % (
+            asset, frames, stored, added_shapes, stored * LAYOUT_SIZE + added_shapes * SHAPE_SIZE)
+
+    for asset, items in assets:
+        added = 0
+        known = len(shapes)
+        for name, data in items:
+            if name in names:
+                raise ValueError('frame %s is defined twice' % name)
+            names.add(name)
+            if data not in index:
+                try:
+                    layout = split_eyes(data, shapes)
+                except ValueError as error:
+                    raise ValueError('frame %s: %s' % (name, error))
+                index[data] = len(layouts)
+                layouts.append((layout, name))
+                added += 1
+            defines.append((name, index[data]))
+        report.append(line(asset, len(items), added, len(shapes) - known))
+
+    report.append(line('total', len(defines), len(layouts), len(shapes)))
+    report.append('%-16s %5d bytes as whole frames' % ('', len(layouts) * WIDTH))
+    return layouts, sorted(shapes, key=shapes.get), defines, report
+
+
+def header(layouts, shapes, defines, source):
+    out = ['//--------------------------------------------------------------',
+           '//-- Generated by tools/eye_assets.py from %s' % source,
+           '//-- Do not edit: change the art and run the tool again.',
+           '//-- The tables are static, include it from one .cpp only',
+           '//--------------------------------------------------------------',
+           '#ifndef Pando_eye_frames_h',
+           '#define Pando_eye_frames_h',
+           '']
+    width = max(len(symbol(name)) for name, _ in defines) + 8
+    for name, number in defines:
+        out.append('#define %-*s %d' % (width, 'FRAME_' + symbol(name), number))
+
+    #-- Name shapes after the first frame that uses them
+    users = {}
+    for layout, name in layouts:
+        for shape in (layout[0], layout[2]):
+            if shape != NO_SHAPE:
+                users.setdefault(shape & ~MIRROR, name)
+
+    out += ['',
+            '#define %-*s %d' % (width, 'EYE_FRAMES', len(layouts)),
+            '#define %-*s %d' % (width, 'EYE_SHAPES', len(shapes)),
+            '',
+            '//-- Every eye once, from its left column. One byte per column, bit 7 the top row',
+            'static const uint8_t eye_shapes[EYE_SHAPES][EYE_SHAPE_SIZE] PROGMEM = {']
+    for i, content in enumerate(shapes):
+        padded = content + bytes(SHAPE_SIZE - len(content))
+        end = ',' if i + 1 < len(shapes) else ''
+        out.append('  { %s }%s   //-- %s' % (', '.join('0x%02X' % b for b in padded), end, users[i]))
+
+    def eye(shape):
+        if shape == NO_SHAPE:
+            return 'EYE_NO_SHAPE'
+        return ('EYE_MIRROR | %d' % (shape & ~MIRROR)) if shape & MIRROR else str(shape)
+
+    out += ['};',
+            '',
+            '//-- The eyes of every frame: shape and column of the left eye, then of the right one',
+            'static const uint8_t eye_layouts[EYE_FRAMES][EYE_LAYOUT_SIZE] PROGMEM = {']
+    lines = []
+    for i, (layout, name) in enumerate(layouts):
+        end = ',' if i + 1 < len(layouts) else ''
+        lines.append(('  { %s, %d, %s, %d }%s' % (eye(layout[0]), layout[1], eye(layout[2]), layout[3], end), name))
+    width = max(len(text) for text, _ in lines) + 3
+    out += ['%-*s//-- %s' % (width, text, name) for text, name in lines]
+    out += ['};', '', '#endif', '']
+    return '\n'.join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('art', help='art file')
+    parser.add_argument('-o', '--output', help='header to write')
+    args = parser.parse_args()
+
+    try:
+        layouts, shapes, defines, report = compile_assets(parse(args.art))
+    except (ValueError, OSError) as error:
+        sys.exit(str(error))
+
+    print('\n'.join(report))
+    if args.output:
+        source = os.path.relpath(args.art, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+        with open(args.output, 'w') as f:
+            f.write(header(layouts, shapes, defines, source.replace(os.sep, '/')))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,243 @@
+//--------------------------------------------------------------
+//-- Builds the compressed eye clips of Pando_eyes.cpp and reports
+//-- how well the clip format does (see EYE_CLIP in Pando_eyes.h)
+//--
+//-- Build and run:
+//--   g++ -O2 -I library/Pando -o eye_clips tools/eye_clips.cpp library/Pando/Pando_eyes.cpp
+//--   ./eye_clips            compression ratio and decoding speed
+//--   ./eye_clips --emit     the clips, as C source for Pando_eyes.cpp
+//--
+//-- Every frame is coded against the previous one: columns that stay are
+//-- skipped, repeated bytes become runs, the rest literals
+//--------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "Pando_eyes.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+struct Frame {
+  uint8_t columns[EYE_FRAME_SIZE];
+  uint8_t time;                         //-- x10 ms
+};
+
+struct Sequence {
+  const char *name;
+  uint8_t mode;
+  std::vector<Frame> frames;
+  bool emit;                            //-- Shipped in Pando_eyes.cpp
+};
+
+static Frame expressionFrame(int expression, uint8_t time){
+
+  Frame frame;
+  eyeFrame(expression, frame.columns);
+  frame.time = time;
+  return frame;
+}
+
+static Frame renderedFrame(int x, int y, int top, int bottom, uint8_t time){
+
+  EyeParams eye = {(int8_t)x, (int8_t)y, (uint8_t)top, (uint8_t)bottom, SHAPE_ROUND};
+  Frame frame;
+  renderEyes(frame.columns, eye);
+  frame.time = time;
+  return frame;
+}
+
+//-- Length of the run of equal bytes from a column
+static int runLength(const uint8_t *frame, int column){
+
+  int length = 1;
+  while (column + length < EYE_FRAME_SIZE && frame[column + length] == frame[column]) length++;
+  return length;
+}
+
+//-- Length of the columns that stay from the previous frame
+static int skipLength(const uint8_t *frame, const uint8_t *previous, int column){
+
+  int length = 0;
+  while (previous && column + length < EYE_FRAME_SIZE && frame[column + length] == previous[column + length]) length++;
+  return length;
+}
+
+static void encodeFrame(Bytes &out, const Frame &frame, const uint8_t *previous){
+
+  const uint8_t *columns = frame.columns;
+  out.push_back(frame.time);
+
+  int column = 0;
+  while (column < EYE_FRAME_SIZE) {
+    int skip = skipLength(columns, previous, column);
+    int run = runLength(columns, column);
+
+    //-- Nothing changes until the end
+    if (column + skip == EYE_FRAME_SIZE) break;
+
+    if (skip > 0 && skip >= run) {
+      out.push_back(CLIP_SKIP | (skip - 1));
+      column += skip;
+    }
+    else if (run >= 2) {
+      out.push_back(CLIP_RUN | (run - 1));
+      out.push_back(columns[column]);
+      column += run;
+    }
+    else {
+      //-- Literal up to the next skip or run
+      int length = 1;
+      while (column + length < EYE_FRAME_SIZE &&
+             skipLength(columns, previous, column + length) == 0 &&
+             runLength(columns, column + length) < 2) length++;
+      out.push_back(CLIP_LITERAL | (length - 1));
+      out.insert(out.end(), columns + column, columns + column + length);
+      column += length;
+    }
+  }
+  out.push_back(CLIP_END);
+}
+
+static Bytes encodeClip(const Sequence &sequence){
+
+  Bytes out;
+  out.push_back(sequence.mode | EYE_CLIP);
+  out.push_back(sequence.frames.size());
+
+  const uint8_t *previous = NULL;     //-- The first frame is a key frame
+  for (size_t i = 0; i < sequence.frames.size(); i++) {
+    encodeFrame(out, sequence.frames[i], previous);
+    previous = sequence.frames[i].columns;
+  }
+  return out;
+}
+
+//-- Decode a whole clip over a frame, checking every frame. Returns false on a mismatch
+static bool decodeClip(const Bytes &clip, const Sequence *check, uint8_t *frame){
+
+  const uint8_t *data = &clip[2];
+  for (int i = 0; i < clip[1]; i++) {
+    uint32_t changed;
+    data++;                             //-- Time
+    data = decodeEyeFrame(data, frame, changed);
+    if (check && memcmp(frame, check->frames[i].columns, EYE_FRAME_SIZE) != 0) return false;
+  }
+  return data == &clip[0] + clip.size();
+}
+
+static std::vector<Sequence> sequences(){
+
+  std::vector<Sequence> list;
+
+  //-- Every expression after the other: frames that have little in common
+  Sequence all = {"expressions", PLAY_ONCE, {}, false};
+  uint8_t probe[EYE_FRAME_SIZE];
+  for (int i = 0; i < EYES; i++)
+    if (eyeFrame(i, probe)) all.frames.push_back(expressionFrame(i, 50));
+  list.push_back(all);
+
+  //-- The expression animations, as clips
+  for (int a = 0; a <= ANIM_GAZE; a++) {
+    const uint8_t *animation = eyeAnimation(a);
+    Sequence sequence = {a == ANIM_BLINK ? "blink" : (a == ANIM_LOVE ? "love" : "gaze"), animation[0], {}, false};
+    for (int i = 0; i < animation[1]; i++)
+      sequence.frames.push_back(expressionFrame(animation[2 + 2 * i], animation[3 + 2 * i]));
+    list.push_back(sequence);
+  }
+
+  //-- The lids close and open again
+  Sequence blink = {"soft_blink", PLAY_ONCE, {}, true};
+  static const uint8_t lids[][3] = {{0, 0, 5}, {1, 0, 3}, {2, 1, 3}, {2, 2, 8}, {2, 1, 3}, {1, 0, 3}, {0, 0, 5}};
+  for (size_t i = 0; i < sizeof(lids) / sizeof(lids[0]); i++)
+    blink.frames.push_back(renderedFrame(0, 0, lids[i][0], lids[i][1], lids[i][2]));
+  list.push_back(blink);
+
+  //-- The pupils go round, with a blink on the way
+  Sequence look = {"look_around", PLAY_LOOP, {}, true};
+  static const int8_t path[][4] = {
+    { 0,  0, 0, 80}, {-1,  0, 0, 60}, {-1, -1, 0, 40}, { 0, -1, 0, 20},
+    { 1, -1, 0, 40}, { 1,  0, 0, 60}, { 1,  0, 2, 8}, { 1,  0, 0, 30}, { 0,  0, 0, 40}
+  };
+  for (size_t i = 0; i < sizeof(path) / sizeof(path[0]); i++)
+    look.frames.push_back(renderedFrame(path[i][0], path[i][1], path[i][2], path[i][2], path[i][3]));
+  list.push_back(look);
+
+  return list;
+}
+
+static void emit(const Sequence &sequence, const Bytes &clip){
+
+  static const char *modes[] = {"PLAY_ONCE", "PLAY_LOOP", "PLAY_PINGPONG"};
+
+  printf("static const uint8_t %s_clip[] PROGMEM = {\n", sequence.name);
+  printf("  EYE_CLIP | %s, %u,", modes[sequence.mode], (unsigned)clip[1]);
+
+  const uint8_t *data = &clip[2];
+  for (int i = 0; i < clip[1]; i++) {
+    const uint8_t *end = data + 1;
+    uint32_t changed;
+    uint8_t frame[EYE_FRAME_SIZE] = {0};
+    end = decodeEyeFrame(end, frame, changed);
+
+    printf("\n  ");
+    for (; data < end; data++)
+      printf("0x%02X%s%s", *data, data + 1 < &clip[0] + clip.size() ? "," : "", data + 1 < end ? " " : "");
+  }
+  printf("\n};\n\n");
+}
+
+int main(int argc, char *argv[]){
+
+  bool emitting = argc > 1 && strcmp(argv[1], "--emit") == 0;
+  std::vector<Sequence> list = sequences();
+
+  size_t raw_total = 0, clip_total = 0;
+  for (size_t i = 0; i < list.size(); i++) {
+    Bytes clip = encodeClip(list[i]);
+    uint8_t frame[EYE_FRAME_SIZE] = {0};
+    if (!decodeClip(clip, &list[i], frame)) {
+      fprintf(stderr, "%s: the clip does not decode back\n", list[i].name);
+      return 1;
+    }
+
+    if (emitting) {
+      if (list[i].emit) emit(list[i], clip);
+      continue;
+    }
+
+    //-- Raw: a 24 byte frame and its time
+    size_t raw = 2 + list[i].frames.size() * (EYE_FRAME_SIZE + 1);
+    raw_total += raw;
+    clip_total += clip.size();
+    printf("%-12s %2zu frames  raw %4zu  clip %4zu bytes  ratio %.2f  %.1f bytes/frame\n",
+           list[i].name, list[i].frames.size(), raw, clip.size(), (double)raw / clip.size(),
+           (double)(clip.size() - 2) / list[i].frames.size());
+  }
+  if (emitting) return 0;
+
+  printf("%-12s            raw %4zu  clip %4zu bytes  ratio %.2f\n", "total", raw_total, clip_total,
+         (double)raw_total / clip_total);
+
+  //-- Decoding speed, on this computer
+  std::vector<Bytes> clips;
+  size_t frames = 0;
+  for (size_t i = 0; i < list.size(); i++) {
+    clips.push_back(encodeClip(list[i]));
+    frames += list[i].frames.size();
+  }
+
+  const int rounds = 20000;
+  uint8_t frame[EYE_FRAME_SIZE] = {0};
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++)
+    for (size_t i = 0; i < clips.size(); i++) decodeClip(clips[i], NULL, frame);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  volatile uint8_t sink = frame[0];    //-- Keep the decoding
+  (void)sink;
+
+  printf("decoding: %.1f M frames/s, %.0f MB/s of frames\n", rounds * frames / seconds / 1e6,
+         rounds * frames * EYE_FRAME_SIZE / seconds / 1e6);
+  return 0;
+}
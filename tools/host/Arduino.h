@@ -0,0 +1,105 @@
+//--------------------------------------------------------------
+//-- The little of the Arduino core the libraries need, to build
+//-- them on a computer (tools/*.cpp). The pins and the time are
+//-- functions the tool defines, core.cpp has the rest. Include
+//-- the C++ headers first: min and max are macros, as on the
+//-- Arduino
+//--------------------------------------------------------------
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A6 20
+#define A7 21
+
+#define DEC 10
+#define HEX 16
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+#define pgm_read_ptr(address) (*(const void * const *)(address))
+#define memcpy_P memcpy
+#define _BV(bit) (1 << (bit))
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+class __FlashStringHelper;
+#define F(string) (reinterpret_cast<const __FlashStringHelper *>(string))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+void delay(unsigned long ms);
+unsigned long millis();
+unsigned long micros();
+
+//-- The rest is in core.cpp, for the tools that build all the libraries
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void delayMicroseconds(unsigned int us);
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+long random(long high);
+long random(long low, long high);
+void randomSeed(unsigned long seed);
+void noInterrupts();
+void interrupts();
+
+class Print {
+public:
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buffer, size_t size);
+  size_t print(const char *s);
+  size_t print(const __FlashStringHelper *s);
+  size_t print(char c);
+  size_t print(int n, int base = DEC);
+  size_t print(unsigned int n, int base = DEC);
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+  size_t println(const char *s);
+  size_t println(const __FlashStringHelper *s);
+  size_t println(char c);
+  size_t println(int n, int base = DEC);
+  size_t println(unsigned int n, int base = DEC);
+  size_t println(long n, int base = DEC);
+  size_t println(unsigned long n, int base = DEC);
+  size_t println(double n, int digits = 2);
+  size_t println();
+};
+
+//-- Nothing comes in
+class Stream : public Print {
+public:
+  int available();
+  int read();
+  int peek();
+};
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud);
+  operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
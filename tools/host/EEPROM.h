@@ -0,0 +1,19 @@
+//--------------------------------------------------------------
+//-- EEPROM on the host (see core.cpp): 1 KB of RAM, as the
+//-- ATmega328
+//--------------------------------------------------------------
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include <Arduino.h>
+
+struct EEPROMClass {
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  void update(int address, uint8_t value);
+  uint16_t length();
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
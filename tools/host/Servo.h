@@ -0,0 +1,25 @@
+//--------------------------------------------------------------
+//-- Servo on the host (see core.cpp): write() only records the
+//-- angle, read() gives it back
+//--------------------------------------------------------------
+#ifndef Servo_h
+#define Servo_h
+
+#include <Arduino.h>
+
+class Servo {
+public:
+  Servo() : angle(90), pin(0) {}
+  uint8_t attach(int pin);
+  void detach();
+  void write(int value);
+  void writeMicroseconds(int value);
+  int read();
+  bool attached();
+
+private:
+  int angle;
+  int pin;
+};
+
+#endif
@@ -0,0 +1,24 @@
+//--------------------------------------------------------------
+//-- I2C on the host (see core.cpp): no device answers, reads
+//-- give 0
+//--------------------------------------------------------------
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+  void begin();
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(bool stop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t stop = 1);
+  size_t write(uint8_t data);
+  size_t write(const uint8_t *data, size_t quantity);
+  int available();
+  int read();
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,71 @@
+//--------------------------------------------------------------
+//-- The Arduino core on the host, but for the pins and the time
+//-- (see Arduino.h): Serial prints to stdout, the servos keep
+//-- their angle, the EEPROM is RAM, nothing answers on I2C
+//--------------------------------------------------------------
+#include <stdio.h>
+#include <Arduino.h>
+#include <Servo.h>
+#include <EEPROM.h>
+#include <Wire.h>
+
+int digitalRead(uint8_t pin){ return LOW; }
+int analogRead(uint8_t pin){ return 512; }
+void delayMicroseconds(unsigned int us){}
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration){}
+void noTone(uint8_t pin){}
+long random(long high){ return high > 0 ? rand() % high : 0; }
+long random(long low, long high){ return high > low ? low + rand() % (high - low) : low; }
+void randomSeed(unsigned long seed){ srand(seed); }
+void noInterrupts(){}
+void interrupts(){}
+
+size_t Print::write(uint8_t c){ return fwrite(&c, 1, 1, stdout); }
+size_t Print::write(const uint8_t *buffer, size_t size){ return fwrite(buffer, 1, size, stdout); }
+size_t Print::print(const char *s){ return printf("%s", s); }
+size_t Print::print(const __FlashStringHelper *s){ return printf("%s", (const char *)s); }
+size_t Print::print(char c){ return printf("%c", c); }
+size_t Print::print(int n, int base){ return print((long)n, base); }
+size_t Print::print(unsigned int n, int base){ return print((unsigned long)n, base); }
+size_t Print::print(long n, int base){ return printf(base == HEX ? "%lX" : "%ld", n); }
+size_t Print::print(unsigned long n, int base){ return printf(base == HEX ? "%lX" : "%lu", n); }
+size_t Print::print(double n, int digits){ return printf("%.*f", digits, n); }
+size_t Print::println(const char *s){ return print(s) + println(); }
+size_t Print::println(const __FlashStringHelper *s){ return print(s) + println(); }
+size_t Print::println(char c){ return print(c) + println(); }
+size_t Print::println(int n, int base){ return print(n, base) + println(); }
+size_t Print::println(unsigned int n, int base){ return print(n, base) + println(); }
+size_t Print::println(long n, int base){ return print(n, base) + println(); }
+size_t Print::println(unsigned long n, int base){ return print(n, base) + println(); }
+size_t Print::println(double n, int digits){ return print(n, digits) + println(); }
+size_t Print::println(){ return printf("\n"); }
+
+int Stream::available(){ return 0; }
+int Stream::read(){ return -1; }
+int Stream::peek(){ return -1; }
+void HardwareSerial::begin(unsigned long baud){}
+HardwareSerial Serial;
+
+uint8_t Servo::attach(int pin){ this->pin = pin; return 0; }
+void Servo::detach(){ pin = 0; }
+void Servo::write(int value){ angle = value; }
+void Servo::writeMicroseconds(int value){ angle = (value - 544) * 180 / (2400 - 544); }
+int Servo::read(){ return angle; }
+bool Servo::attached(){ return pin != 0; }
+
+static uint8_t eeprom[1024];
+uint8_t EEPROMClass::read(int address){ return eeprom[address & 1023]; }
+void EEPROMClass::write(int address, uint8_t value){ eeprom[address & 1023] = value; }
+void EEPROMClass::update(int address, uint8_t value){ eeprom[address & 1023] = value; }
+uint16_t EEPROMClass::length(){ return sizeof(eeprom); }
+EEPROMClass EEPROM;
+
+void TwoWire::begin(){}
+void TwoWire::beginTransmission(uint8_t address){}
+uint8_t TwoWire::endTransmission(bool stop){ return 2; }   //-- NACK on the address
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t stop){ return 0; }
+size_t TwoWire::write(uint8_t data){ return 1; }
+size_t TwoWire::write(const uint8_t *data, size_t quantity){ return quantity; }
+int TwoWire::available(){ return 0; }
+int TwoWire::read(){ return 0; }
+TwoWire Wire;
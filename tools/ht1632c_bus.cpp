@@ -0,0 +1,290 @@
+//--------------------------------------------------------------
+//-- Checks the bits the HT1632C transports send (see
+//-- DFRobot_HT1632C_Serial): the same drawing goes through the
+//-- digitalWrite() driver and through a mock shift register, and
+//-- the chip must get the same transactions, bit for bit. Then a
+//-- 2x2 grid of chained panels is checked against a model of its
+//-- four chips
+//--
+//-- Build and run:
+//--   g++ -O2 -DARDUINO=100 -I tools/host -I library/DFRobot_HT1632C -o ht1632c_bus
+//--       tools/ht1632c_bus.cpp library/DFRobot_HT1632C/DFRobot_HT1632C.cpp
+//--   ./ht1632c_bus
+//--------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "DFRobot_HT1632C.h"
+
+#define DATA 1
+#define WR 2
+#define CS 3
+
+#define CLOCK 2000000UL           //-- HT1632C_SERIAL_CLOCK
+
+typedef std::vector<bool> Bits;
+
+//-- The CS pins of the 2x2 grid, row by row
+static const uint8_t chain_cs[4] = {CS, 4, 5, 6};
+
+//-- What the chips see: a transaction from CS low to CS high, and
+//-- the chip it went to
+static std::vector<Bits> bus;
+static std::vector<uint8_t> owner;
+static uint8_t pins[8] = {0, 0, HIGH, HIGH, HIGH, HIGH, HIGH, 0};
+static bool hardware = false;     //-- The shift register has the pins
+static bool misused = false;
+
+void pinMode(uint8_t pin, uint8_t mode){}
+void delay(unsigned long ms){}
+unsigned long millis(){return 0;}
+unsigned long micros(){return 0;}
+
+void digitalWrite(uint8_t pin, uint8_t value){
+  if (hardware && (pin == DATA || pin == WR)) misused = true;
+
+  bool selected = false;
+  for (uint8_t chip = 0; chip < 4; chip++) selected |= pins[chain_cs[chip]] == LOW;
+
+  if (pin >= CS && pin < CS + 4 && value == LOW && pins[pin] == HIGH) {
+    bus.push_back(Bits());
+    owner.push_back(pin - CS);
+  }
+  if (pin == WR && value == HIGH && pins[WR] == LOW && selected) bus.back().push_back(pins[DATA]);
+  pins[pin] = value;
+}
+
+//-- The transport under test, with a shift register that only records
+class MockSerial : public DFRobot_HT1632C_Serial<DATA, WR, CS> {
+public:
+  unsigned long bytes;
+
+  MockSerial() : bytes(0) {}
+
+protected:
+  virtual void start(){
+    if (hardware) misused = true;
+    hardware = true;
+  }
+
+  virtual void stop(){
+    hardware = false;
+  }
+
+  virtual void shiftOut(uint8_t data){
+    if (!hardware || pins[CS] != LOW) misused = true;
+    for (int i = 7; i >= 0; i--) bus.back().push_back((data >> i) & 1);
+    bytes++;
+  }
+};
+
+//-- Some drawing: commands, whole screens, columns and flush() of
+//-- changes of every size
+static void draw(DFRobot_HT1632C &display, unsigned seed){
+
+  srand(seed);
+  display.begin();
+  display.isLedOn(true);
+  display.setPwm(7);
+  display.fillScreen();
+  display.drawText("Hi", 0, 0, FONT_8X4, FONT_8X4_END, FONT_8X4_HEIGHT);
+  display.writeScreen();
+
+  for (int frame = 0; frame < 2000; frame++) {
+    uint8_t *matrix = display.getBuffer();
+    for (int i = rand() % 6; i > 0; i--) {
+      if (rand() % 3) matrix[rand() % WIDTHSIZE] ^= 1 << (rand() % 8);
+      else matrix[rand() % WIDTHSIZE] = rand();
+    }
+    if (frame % 100 == 99) display.writeColumns(rand() % WIDTHSIZE, 1 + rand() % 8);
+    else display.flush();
+  }
+}
+
+//-- The display RAM of a chip after a run, nibble by nibble
+static void ram(const std::vector<Bits> &transactions, uint8_t *nibbles, int chip = -1){
+
+  for (size_t t = 0; t < transactions.size(); t++) {
+    if (chip >= 0 && owner[t] != chip) continue;
+    const Bits &bits = transactions[t];
+    if (bits.size() < 3 || !(bits[0] && !bits[1] && bits[2])) continue;   //-- Write: 101
+
+    uint8_t address = 0;
+    for (int i = 3; i < 10; i++) address = (address << 1) | bits[i];
+    for (size_t i = 10; i + 4 <= bits.size(); i += 4, address++)
+      nibbles[address & 0x7F] = (bits[i] << 3) | (bits[i + 1] << 2) | (bits[i + 2] << 1) | bits[i + 3];
+  }
+}
+
+//-- A pixel of the frame a display draws (see getBuffer)
+static bool drawn(DFRobot_HT1632C &display, int x, int y){
+
+  return display.getBuffer()[x * (display.getHeight() >> 3) + (y >> 3)] & (0x80 >> (y & 7));
+}
+
+//-- A pixel of the 2x2 grid, from the RAM of its chip
+static bool lit(int x, int y){
+
+  static uint8_t nibbles[4][128];
+  uint8_t chip = (y / HEIGHTSIZE) * 2 + x / WIDTHSIZE;
+  memset(nibbles[chip], 0, 128);
+  ram(bus, nibbles[chip], chip);
+  return nibbles[chip][4 * (x % WIDTHSIZE) + (y % HEIGHTSIZE) / 4] & (8 >> (y % 4));
+}
+
+//-- The grid must show what it drew, pixel for pixel
+static bool shows(DFRobot_HT1632C &display){
+
+  for (int x = 0; x < display.getWidth(); x++)
+    for (int y = 0; y < display.getHeight(); y++)
+      if (lit(x, y) != drawn(display, x, y)) {
+        fprintf(stderr, "pixel %d,%d of the grid is not the frame\n", x, y);
+        return false;
+      }
+  return true;
+}
+
+//-- Chained panels: the layout of chipOffset() and pixelOffset(), the
+//-- chips a change writes to, and the clipping at the edges
+static bool chained(){
+
+  static uint8_t memory[HT1632C_MEMORY(4) + 1];
+  memory[HT1632C_MEMORY(4)] = 0x5A;         //-- Guard
+  DFRobot_HT1632C grid(DATA, WR, chain_cs, 2, 2, memory);
+
+  bus.clear();
+  owner.clear();
+  grid.begin();
+  grid.clearScreen();
+  if (grid.getWidth() != 2 * WIDTHSIZE || grid.getHeight() != 2 * HEIGHTSIZE) {
+    fprintf(stderr, "the grid is %dx%d\n", grid.getWidth(), grid.getHeight());
+    return false;
+  }
+
+  //-- Pixels everywhere, across the borders, each one where it was set
+  static bool want[48][16];
+  srand(3);
+  for (int t = 0; t < 3000; t++) {
+    int x = rand() % 48, y = rand() % 16;
+    want[x][y] = rand() % 2;
+    if (want[x][y]) grid.setPixel(x, y);
+    else grid.clrPixel(x, y);
+    if (t % 300 == 299) {
+      grid.flush();
+      if (!shows(grid)) return false;
+      for (x = 0; x < 48; x++)
+        for (y = 0; y < 16; y++)
+          if (lit(x, y) != want[x][y]) {
+            fprintf(stderr, "pixel %d,%d is not where it was set\n", x, y);
+            return false;
+          }
+    }
+  }
+
+  //-- A one pixel change writes to its chip only
+  grid.flush();
+  size_t before = bus.size();
+  grid.setPixel(30, 12);
+  grid.flush();
+  if (bus.size() != before + 1 || owner.back() != 3) {
+    fprintf(stderr, "one pixel of chip 3 took %zu transactions\n", bus.size() - before);
+    return false;
+  }
+
+  //-- Text across both borders: the same glyphs as on a single panel
+  DFRobot_HT1632C left(DATA, WR, CS), right(DATA, WR, CS);
+  left.drawText("HELLO", 20, 0, FONT_8X4, FONT_8X4_END, FONT_8X4_HEIGHT);
+  right.drawText("HELLO", -4, 0, FONT_8X4, FONT_8X4_END, FONT_8X4_HEIGHT);
+  grid.clearScreen();
+  grid.drawText("HELLO", 20, 4, FONT_8X4, FONT_8X4_END, FONT_8X4_HEIGHT);
+  grid.flush();
+  for (int x = 0; x < 48; x++)
+    for (int y = 0; y < 16; y++) {
+      bool text = y >= 4 && y < 12 && x >= 20 &&
+                  (x < 24 ? drawn(left, x, y - 4) : drawn(right, x - 24, y - 4));
+      if (drawn(grid, x, y) != text || lit(x, y) != text) {
+        fprintf(stderr, "text pixel %d,%d is wrong\n", x, y);
+        return false;
+      }
+    }
+
+  //-- Clipped at the right and bottom edges, not wrapped
+  grid.clearScreen();
+  grid.drawText("HELLO", 40, 12, FONT_8X4, FONT_8X4_END, FONT_8X4_HEIGHT);
+  grid.setPixel(48, 0);
+  grid.setPixel(0, 16);
+  grid.drawLine(40, 15, 60, 15);
+  grid.flush();
+  if (!shows(grid)) return false;
+  for (int x = 0; x < 48; x++)
+    for (int y = 0; y < 16; y++)
+      if ((x < 40 || y < 12) && lit(x, y)) {
+        fprintf(stderr, "pixel %d,%d lit past an edge\n", x, y);
+        return false;
+      }
+  if (!lit(40, 15) || !lit(47, 15) || memory[HT1632C_MEMORY(4)] != 0x5A) {
+    fprintf(stderr, "the clipping at the edges is wrong\n");
+    return false;
+  }
+
+  //-- writeColumns() across the vertical border writes the four chips
+  grid.clearScreen();
+  memset(grid.getBuffer(), 0xFF, 48 * 2);
+  before = bus.size();
+  grid.writeColumns(20, 8);
+  uint8_t chips = 0;
+  for (size_t t = before; t < bus.size(); t++) chips |= 1 << owner[t];
+  if (chips != 0xF || !lit(20, 0) || !lit(27, 15) || lit(28, 0) || lit(19, 15)) {
+    fprintf(stderr, "writeColumns() across the border is wrong\n");
+    return false;
+  }
+
+  printf("2x2 grid: pixels, text and clipping match, one pixel writes one chip\n");
+  return true;
+}
+
+int main(){
+
+  DFRobot_HT1632C reference(DATA, WR, CS);
+  draw(reference, 1);
+  std::vector<Bits> expected = bus;
+
+  bus.clear();
+  MockSerial serial;
+  draw(serial, 1);
+
+  if (misused) {
+    fprintf(stderr, "the pins were bit-banged while the shift register had them\n");
+    return 1;
+  }
+  if (bus != expected) {
+    size_t t = 0;
+    while (t < bus.size() && t < expected.size() && bus[t] == expected[t]) t++;
+    fprintf(stderr, "transaction %zu of %zu differs\n", t, expected.size());
+    return 1;
+  }
+
+  uint8_t nibbles[128] = {0};
+  ram(bus, nibbles);
+  const uint8_t *matrix = serial.getBuffer();
+  for (int c = 0; c < WIDTHSIZE; c++) {
+    if (nibbles[4 * c] != matrix[c] >> 4 || nibbles[4 * c + 1] != (matrix[c] & 0xF)) {
+      fprintf(stderr, "column %d of the display RAM is not the frame\n", c);
+      return 1;
+    }
+  }
+
+  unsigned long bits = 0;
+  for (size_t t = 0; t < bus.size(); t++) bits += bus[t].size();
+  unsigned long full = 3 + 7 + WIDTHSIZE * 16;
+  const HT1632C_Stats &stats = serial.getStats();
+
+  printf("%zu transactions, %lu bits: the same as digitalWrite()\n", bus.size(), bits);
+  printf("shift register %lu bytes, bit-banged %lu bits\n", serial.bytes, bits - 8 * serial.bytes);
+  printf("whole frame   %3lu bits = %lu bytes + %lu bits, %4.0f us of WR clock\n",
+         full, full / 8, full % 8, full * 1e6 / CLOCK);
+  printf("flush()       %5.1f bits per frame, %4.1f us of WR clock\n",
+         (double)stats.bits / stats.frames, (double)stats.bits / stats.frames * 1e6 / CLOCK);
+
+  return chained() ? 0 : 1;
+}
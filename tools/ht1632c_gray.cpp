@@ -0,0 +1,157 @@
+//--------------------------------------------------------------
+//-- Checks the gray levels of DFRobot_HT1632C_Gray: a model of
+//-- the chip decodes the RAM writes and the PWM commands, and
+//-- adds up how long every LED is lit, weighted by the PWM duty.
+//-- Each level must come out as level / (2^BITS - 1) of the
+//-- brightest one, with the planes timed or weighted by the PWM
+//--
+//-- Build and run:
+//--   g++ -O2 -DARDUINO=100 -I tools/host -I library/DFRobot_HT1632C -o ht1632c_gray
+//--       tools/ht1632c_gray.cpp library/DFRobot_HT1632C/DFRobot_HT1632C.cpp
+//--   ./ht1632c_gray
+//--------------------------------------------------------------
+#include <stdio.h>
+#include "DFRobot_HT1632C.h"
+
+#define SECONDS 2
+
+static unsigned long now = 0;     //-- us, a little later at every call
+
+void pinMode(uint8_t pin, uint8_t mode){}
+void digitalWrite(uint8_t pin, uint8_t value){}
+void delay(unsigned long ms){ now += ms * 1000; }
+unsigned long millis(){ return now / 1000; }
+unsigned long micros(){ return now += 4; }
+
+//-- The chip: a transaction is decoded as the bits come
+class Chip : public DFRobot_HT1632C {
+public:
+  uint8_t ram[128];
+  uint8_t pwm;
+
+  Chip() : DFRobot_HT1632C(1, 2, 3), pwm(15) { memset(ram, 0, sizeof(ram)); }
+
+  bool lit(uint8_t x, uint8_t y){ return ram[4 * x + y / 4] & (8 >> (y % 4)); }
+
+protected:
+  virtual void select(uint8_t chip){ count = 0; bits = 0; }
+  virtual void deselect(uint8_t chip){}
+
+  virtual void writeBits(uint16_t data, uint8_t length){
+    while (length--) {
+      bits = (bits << 1) | ((data >> length) & 1);
+      count++;
+      if (count == 3) mode = bits;
+      else if (mode == DFROBOT_HT1632_COMMAND && count == 12) {
+        uint8_t command = bits >> 1;
+        if ((command & 0xF0) == DFROBOT_HT1632_PWM_CONTROL) pwm = command & 0xF;
+      }
+      else if (mode == DFROBOT_HT1632_WRITE && count == 10) address = bits & 0x7F;
+      else if (mode == DFROBOT_HT1632_WRITE && count > 10 && (count - 10) % 4 == 0)
+        ram[address++ & 0x7F] = bits & 0xF;
+    }
+  }
+
+private:
+  uint32_t bits;
+  uint16_t count;
+  uint8_t mode, address;
+};
+
+//-- Every level on the screen, lit time over SECONDS of update()
+template<uint8_t BITS> static bool check(bool pwm){
+
+  const uint8_t levels = 1 << BITS;
+  Chip chip;
+  chip.begin();
+  chip.clearScreen();
+
+  DFRobot_HT1632C_Gray<BITS> gray(chip);
+  gray.usePwm(pwm);
+  for (uint8_t x = 0; x < WIDTHSIZE; x++)
+    for (uint8_t y = 0; y < HEIGHTSIZE; y++) gray.setPixel(x, y, (x + 3 * y) % levels);
+
+  for (uint8_t x = 0; x < WIDTHSIZE; x++)
+    for (uint8_t y = 0; y < HEIGHTSIZE; y++)
+      if (gray.getPixel(x, y) != (x + 3 * y) % levels) {
+        fprintf(stderr, "getPixel(%d, %d) is not the level set\n", x, y);
+        return false;
+      }
+
+  double on[levels];
+  unsigned long pixels[levels];
+  memset(on, 0, sizeof(on));
+  memset(pixels, 0, sizeof(pixels));
+
+  //-- The first update() shows plane 0: stop at a plane 0 again, whole
+  //-- cycles weigh the planes right
+  gray.update();
+  unsigned long start = now, last = now, planes = 0;
+  while (true) {
+    for (uint8_t x = 0; x < WIDTHSIZE; x++)
+      for (uint8_t y = 0; y < HEIGHTSIZE; y++)
+        if (chip.lit(x, y)) on[(x + 3 * y) % levels] += (now - last) * (chip.pwm + 1) / 16.0;
+    last = now;
+    if (gray.update() && ++planes % BITS == 0 && now - start >= SECONDS * 1000000UL) break;
+  }
+  for (uint8_t x = 0; x < WIDTHSIZE; x++)
+    for (uint8_t y = 0; y < HEIGHTSIZE; y++) pixels[(x + 3 * y) % levels]++;
+
+  double full = on[levels - 1] / pixels[levels - 1];
+  double error = 0;
+  for (uint8_t level = 0; level < levels; level++) {
+    double e = fabs(on[level] / pixels[level] / full - (double)level / (levels - 1));
+    if (e > error) error = e;
+  }
+
+  printf("%d bits, %s: %5.0f cycles/s, largest error %.4f of the brightest level\n",
+         BITS, pwm ? "PWM " : "time", planes * 1e6 / BITS / (now - start), error);
+  if (error > 0.001) {
+    fprintf(stderr, "the levels are off\n");
+    return false;
+  }
+  return true;
+}
+
+//-- Three panels chained: the planes are the memory given, and
+//-- nothing is written past them. Without memory nothing is written
+static bool chained(){
+
+  static const uint8_t cs[3] = {3, 4, 5};
+  static uint8_t memory[HT1632C_MEMORY(3)];
+  static uint8_t planes[HT1632C_GRAY_MEMORY(3, 3) + 1];
+  DFRobot_HT1632C display(1, 2, cs, 3, 1, memory);
+  display.begin();
+
+  planes[sizeof(planes) - 1] = 0x5A;
+  DFRobot_HT1632C_Gray<3> gray(display, planes);
+  for (uint8_t x = 0; x < 255; x++)
+    for (uint8_t y = 0; y < 16; y++) gray.setPixel(x, y, x + y);
+  for (uint8_t x = 0; x < 3 * WIDTHSIZE; x++)
+    for (uint8_t y = 0; y < HEIGHTSIZE; y++)
+      if (gray.getPixel(x, y) != (x + y) % 8) {
+        fprintf(stderr, "chained: getPixel(%d, %d) is not the level set\n", x, y);
+        return false;
+      }
+  if (planes[sizeof(planes) - 1] != 0x5A || gray.getPlane(2) != planes + 2 * 3 * WIDTHSIZE) {
+    fprintf(stderr, "chained: the planes are not the memory given\n");
+    return false;
+  }
+
+  DFRobot_HT1632C_Gray<3> single(display);
+  single.setPixel(30, 0, 7);
+  if (single.getPixel(30, 0) || single.getPlane(0) || single.update()) {
+    fprintf(stderr, "chained: the planes of a single panel were used\n");
+    return false;
+  }
+
+  printf("3 panels: the planes stay in the memory given\n");
+  return true;
+}
+
+int main(){
+
+  bool ok = check<2>(false) && check<3>(false) && check<4>(false)
+         && check<2>(true) && check<3>(true) && check<4>(true) && chained();
+  return ok ? 0 : 1;
+}
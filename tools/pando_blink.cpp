@@ -0,0 +1,139 @@
+//--------------------------------------------------------------
+//-- Checks the auto-blink of Pando under a sketch that draws the
+//-- eyes at every loop(), as drawEyes() allows. The display is
+//-- read back from its pins: a blink must keep the eyes closed
+//-- BLINK_TIME_MIN to BLINK_TIME_MAX ms, and the next one must
+//-- wait at least half the interval, whether the sketch draws
+//-- the same eyes or moves them. After print(), the text stays
+//-- as it is until the sketch puts eyes again
+//--
+//-- Build and run:
+//--   g++ -O2 -DARDUINO=100 -I tools/host -I library/Pando -I library/Oscillator
+//--       -I library/BatReader -I library/Gyro -I library/DFRobot_HT1632C
+//--       -o pando_blink tools/pando_blink.cpp tools/host/core.cpp library/*/*.cpp
+//--   ./pando_blink
+//--------------------------------------------------------------
+#include <stdio.h>
+#include "Pando.h"
+
+#define DATA 11                   //-- The display pins of Pando
+#define WR 10
+#define CS 12
+
+#define INTERVAL 1000
+#define SECONDS 60
+
+static unsigned long now = 0;     //-- us
+static uint8_t pins[32];
+static uint32_t bits;             //-- Of the transaction
+static uint16_t count;
+static uint8_t ram[128];          //-- The display RAM, nibble by nibble
+
+void pinMode(uint8_t pin, uint8_t mode){}
+void delay(unsigned long ms){ now += ms * 1000; }
+unsigned long millis(){ return ++now / 1000; }   //-- print() waits on it
+unsigned long micros(){ return now; }
+
+//-- A RAM write: 101, 7 bits of address, then nibbles
+void digitalWrite(uint8_t pin, uint8_t value){
+
+  if (pin == CS && value == LOW) count = 0;
+  if (pin == WR && value == HIGH && pins[WR] == LOW && pins[CS] == LOW) {
+    bits = (bits << 1) | pins[DATA];
+    count++;
+    static uint8_t mode, address;
+    if (count == 3) mode = bits & 7;
+    else if (mode == DFROBOT_HT1632_WRITE && count == 10) address = bits & 0x7F;
+    else if (mode == DFROBOT_HT1632_WRITE && count > 10 && (count - 10) % 4 == 0)
+      ram[address++ & 0x7F] = bits & 0xF;
+  }
+  pins[pin] = value;
+}
+
+static bool showing(const uint8_t *frame){
+
+  for (uint8_t c = 0; c < EYE_FRAME_SIZE; c++)
+    if (((ram[4 * c] << 4) | ram[4 * c + 1]) != frame[c]) return false;
+  return true;
+}
+
+//-- SECONDS of loop() every ms. moving: the pupils move every 50 ms
+static bool run(Pando &pando, bool moving){
+
+  uint8_t closed[EYE_FRAME_SIZE];
+  eyeFrame(happyClosed, closed);
+
+  unsigned long start = millis(), shut = 0, opened = 0;
+  unsigned int blinks = 0, shortest = 60000, longest = 0, gap = 60000;
+  bool was = false;
+
+  while (millis() - start < SECONDS * 1000UL) {
+    int8_t x = moving ? (millis() / 50) % 5 - 2 : 0;
+    pando.drawEyes(x, 0);
+    pando.update();
+
+    bool is = showing(closed);
+    if (is && !was) {
+      blinks++;
+      shut = millis();
+      if (opened && shut - opened < gap) gap = shut - opened;
+    }
+    if (!is && was) {
+      opened = millis();
+      if (opened - shut < shortest) shortest = opened - shut;
+      if (opened - shut > longest) longest = opened - shut;
+    }
+    was = is;
+    delay(1);
+  }
+
+  printf("%s eyes: %u blinks in %d s, closed %u to %u ms, at least %u ms apart\n",
+         moving ? "moving" : "same  ", blinks, SECONDS, shortest, longest, gap);
+
+  if (gap < INTERVAL / 2) {
+    fprintf(stderr, "the blinks come too often\n");
+    return false;
+  }
+  //-- Moving eyes may cut a blink short, the same eyes never
+  if (!moving && (blinks == 0 || shortest < BLINK_TIME_MIN || longest > BLINK_TIME_MAX + 1)) {
+    fprintf(stderr, "the blinks are not as long as they should\n");
+    return false;
+  }
+  return true;
+}
+
+//-- SECONDS of update() every ms after print(): no blink over the text
+static bool text(Pando &pando){
+
+  uint8_t closed[EYE_FRAME_SIZE], shown[EYE_FRAME_SIZE];
+  eyeFrame(happyClosed, closed);
+  pando.print("Hi", 10);
+  for (uint8_t c = 0; c < EYE_FRAME_SIZE; c++) shown[c] = (ram[4 * c] << 4) | ram[4 * c + 1];
+
+  unsigned int changes = 0;
+  unsigned long start = millis();
+  while (millis() - start < SECONDS * 1000UL) {
+    pando.update();
+    if (showing(closed) || !showing(shown)) changes++;
+    delay(1);
+  }
+
+  printf("text       : display changed %u ms in %d s\n", changes, SECONDS);
+  if (changes) {
+    fprintf(stderr, "the eyes blink over the text\n");
+    return false;
+  }
+  return true;
+}
+
+int main(){
+
+  Pando pando;
+  pando.init(2, 3, 4, 5, false);
+  pando.setAutoBlink(true, INTERVAL);
+
+  bool ok = run(pando, false) && run(pando, true) && text(pando);
+  pando.putEyes(happyOpen);
+  ok = ok && run(pando, false);
+  return ok ? 0 : 1;
+}
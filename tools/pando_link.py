@@ -0,0 +1,547 @@
+#!/usr/bin/env python3
+"""Upload gesture programs to Pando over a serial port (see Pando_link.h).
+
+The robot must run a sketch with a PandoLink, like examples/Pando_link.
+
+    pando_link.py --port /dev/ttyUSB0 ping
+    pando_link.py --port /dev/ttyUSB0 play nod.txt [--priority HIGH]
+    pando_link.py --port /dev/ttyUSB0 store 0 nod.txt [--play]
+    pando_link.py --port /dev/ttyUSB0 play-slot 0
+    pando_link.py --port /dev/ttyUSB0 stop
+    pando_link.py assemble nod.txt          (prints the bytecode)
+    pando_link.py fake                      (a fake Pando on a pseudo terminal)
+    pando_link.py selftest                  (this tool against the fake Pando)
+
+Gesture text: one instruction per line, '#' starts a comment. The names are
+the ones of the library headers (POSE_*, GAIT_*, eye expressions, note_*),
+with or without their prefix:
+
+    eyes happyOpen
+    loop 3
+      pose HEAD_LEFT 200          # pose, time (ms)
+      tone note_E6 50 0           # frequency, duration, silence
+      sync servos                 # servos, sound or all
+      pose HEAD_RIGHT 200
+      tone note_A6 50 0
+      sync servos
+    next
+    gait WALK 2 1000 20 1         # gait, steps, T, h, dir
+    bend note_A5 note_A6 1.02 10 1    # f0, f1, prop, note, silence
+    bends 400 200 100 3 1.03 10 1     # f, span, step, count, prop, note, silence
+    wait 300
+    home                          # [time]
+    detach
+    end                           # added if missing
+
+Only the standard library is needed: the port is opened with termios.
+"""
+
+import argparse
+import os
+import re
+import select
+import sys
+import termios
+import threading
+import time
+import tty
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+LIBRARY = os.path.join(HERE, '..', 'library', 'Pando')
+HEADERS = ['Pando_timeline.h', 'Pando_gaits.h', 'Pando_eyes.h', 'Pando_sounds.h',
+           'Pando_gestures.h', 'Pando_link.h']
+
+
+def load_defines():
+    """Numeric #defines of the library headers, so that both sides agree."""
+    defines = {}
+    pattern = re.compile(r'^\s*#define\s+(\w+)\s+([-+0-9.xXa-fA-F]+)\b')
+    for header in HEADERS:
+        with open(os.path.join(LIBRARY, header)) as f:
+            for line in f:
+                match = pattern.match(line)
+                if not match:
+                    continue
+                value = match.group(2)
+                try:
+                    defines[match.group(1)] = int(value, 0)
+                except ValueError:
+                    try:
+                        defines[match.group(1)] = float(value)
+                    except ValueError:
+                        pass
+    return defines
+
+
+D = load_defines()
+
+#-- Operand bytes of every opcode, as in Pando_link.cpp
+OPERANDS = {D['OP_END']: 0, D['OP_POSE']: 3, D['OP_HOME']: 2, D['OP_GAIT']: 6,
+            D['OP_EYES']: 1, D['OP_TONE']: 5, D['OP_BEND']: 7, D['OP_BENDS']: 10,
+            D['OP_WAIT']: 2, D['OP_SYNC']: 1, D['OP_LOOP']: 1, D['OP_NEXT']: 0,
+            D['OP_DETACH']: 0}
+
+STATUS = {D['LINK_OK']: 'ok', D['LINK_BAD_CRC']: 'bad CRC',
+          D['LINK_BAD_LENGTH']: 'bad length', D['LINK_BAD_COMMAND']: 'bad command',
+          D['LINK_BAD_PROGRAM']: 'bad program', D['LINK_BAD_SLOT']: 'bad slot',
+          D['LINK_EMPTY_SLOT']: 'empty slot'}
+
+
+class LinkError(Exception):
+    pass
+
+
+#--------------------------------------------------------------
+#-- Assembler
+#--------------------------------------------------------------
+def value(token, prefixes=('',), line=0):
+    """A number or a header name, tried with each prefix."""
+    for prefix in prefixes:
+        if prefix + token in D:
+            return D[prefix + token]
+    try:
+        return float(token) if '.' in token else int(token, 0)
+    except ValueError:
+        raise LinkError('line %d: unknown name %s' % (line, token))
+
+
+def word(number):
+    number = int(number) & 0xFFFF          # truncated, as G_WORD() does
+    return [number & 0xFF, number >> 8]
+
+
+def byte(number, line, signed=False):
+    number = int(round(number))
+    if not (-128 if signed else 0) <= number <= (127 if signed else 255):
+        raise LinkError('line %d: %d does not fit in a byte' % (line, number))
+    return number & 0xFF
+
+
+def prop(number, line):
+    return byte((number - 1) * 1000, line)
+
+
+def assemble(text):
+    code = []
+    for n, raw in enumerate(text.splitlines(), 1):
+        tokens = raw.split('#')[0].split()
+        if not tokens:
+            continue
+        op, args = tokens[0].lower(), tokens[1:]
+        note = lambda t: value(t, ('', 'note_'), n)
+
+        def need(count):
+            if len(args) != count:
+                raise LinkError('line %d: %s takes %d values' % (n, op, count))
+
+        if op == 'end':
+            need(0)
+            code += [D['OP_END']]
+        elif op == 'pose':
+            need(2)
+            code += [D['OP_POSE'], byte(value(args[0], ('', 'POSE_'), n), n)] + word(value(args[1]))
+        elif op == 'home':
+            code += [D['OP_HOME']] + word(value(args[0]) if args else 500)
+        elif op == 'gait':
+            need(5)
+            code += [D['OP_GAIT'], byte(value(args[0], ('', 'GAIT_'), n), n),
+                     byte(float(args[1]) * 10, n)] + word(value(args[2])) + \
+                    [byte(value(args[3]), n, True), byte(value(args[4]), n, True)]
+        elif op == 'eyes':
+            need(1)
+            code += [D['OP_EYES'], byte(value(args[0]), n)]
+        elif op == 'tone':
+            need(3)
+            code += [D['OP_TONE']] + word(note(args[0])) + word(value(args[1])) + \
+                    [byte(value(args[2]), n)]
+        elif op == 'bend':
+            need(5)
+            code += [D['OP_BEND']] + word(note(args[0])) + word(note(args[1])) + \
+                    [prop(float(args[2]), n), byte(value(args[3]), n), byte(value(args[4]), n)]
+        elif op == 'bends':
+            need(7)
+            code += [D['OP_BENDS']] + word(note(args[0])) + word(value(args[1])) + \
+                    word(value(args[2])) + [byte(value(args[3]), n), prop(float(args[4]), n),
+                                            byte(value(args[5]), n), byte(value(args[6]), n)]
+        elif op == 'wait':
+            need(1)
+            code += [D['OP_WAIT']] + word(value(args[0]))
+        elif op == 'sync':
+            need(1)
+            code += [D['OP_SYNC'], value(args[0].upper(), ('SYNC_',), n)]
+        elif op == 'loop':
+            need(1)
+            code += [D['OP_LOOP'], byte(value(args[0]), n)]
+        elif op == 'next':
+            need(0)
+            code += [D['OP_NEXT']]
+        elif op == 'detach':
+            need(0)
+            code += [D['OP_DETACH']]
+        else:
+            raise LinkError('line %d: unknown instruction %s' % (n, op))
+
+    if not code or check_program(code) != len(code):
+        code += [D['OP_END']]
+    if check_program(code) != len(code):
+        raise LinkError('not a valid program (loops, poses, gaits or bends out of range)')
+    if len(code) > D['LINK_PAYLOAD_MAX'] - 1:
+        raise LinkError('%d bytes, Pando takes %d' % (len(code), D['LINK_PAYLOAD_MAX'] - 1))
+    return bytes(code)
+
+
+def signed_word(code, i):
+    number = code[i] | (code[i + 1] << 8)
+    return number - 0x10000 if number & 0x8000 else number
+
+
+def check_gait(gait, period, direction):
+    """Same as checkGait() in Pando_link.cpp."""
+    if not D['GAIT_NONE'] < gait < D['GAITS']:
+        return False
+    if not D['GAIT_T_MIN'] <= period <= D['GAIT_T_MAX']:
+        return False
+    if not -1 <= direction <= 1:
+        return False
+    return direction != 0 or gait > D['GAIT_FLAPPING']
+
+
+def check_bend(f0, f1, prop_byte):
+    """Same as checkBend() in Pando_link.cpp."""
+    return prop_byte != 0 and \
+        D['BEND_FREQ_MIN'] <= f0 <= D['BEND_FREQ_MAX'] and \
+        D['BEND_FREQ_MIN'] <= f1 <= D['BEND_FREQ_MAX']
+
+
+def check_program(code):
+    """Same as PandoLink::checkProgram(): length up to OP_END, 0 if bad."""
+    i, depth = 0, 0
+    while i < len(code):
+        op = code[i]
+        if op not in OPERANDS:
+            return 0
+        following = i + 1 + OPERANDS[op]
+        if following > len(code):
+            return 0
+        if op == D['OP_END']:
+            return following if depth == 0 else 0
+        if op == D['OP_POSE'] and code[i + 1] >= D['POSES']:
+            return 0
+        if op == D['OP_GAIT'] and not check_gait(code[i + 1], signed_word(code, i + 3),
+                                                 code[i + 6] - 256 if code[i + 6] > 127 else code[i + 6]):
+            return 0
+        if op == D['OP_BEND'] and not check_bend(signed_word(code, i + 1),
+                                                 signed_word(code, i + 3), code[i + 5]):
+            return 0
+        if op == D['OP_BENDS']:
+            #-- The first and the last bend of the run bound all the others
+            count = code[i + 7]
+            if count == 0 or count > D['BENDS_MAX']:
+                return 0
+            f, span = signed_word(code, i + 1), signed_word(code, i + 3)
+            shift = signed_word(code, i + 5) * (count - 1)
+            if not check_bend(f, f + span, code[i + 8]) or \
+                    not check_bend(f + shift, f + span + shift, code[i + 8]):
+                return 0
+        if op == D['OP_LOOP']:
+            depth += 1
+            if depth > D['LOOP_DEPTH'] or code[i + 1] == 0:
+                return 0
+        if op == D['OP_NEXT']:
+            depth -= 1
+            if depth < 0:
+                return 0
+        i = following
+    return 0
+
+
+#--------------------------------------------------------------
+#-- Frames
+#--------------------------------------------------------------
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def frame(command, payload=b''):
+    body = bytes([command, len(payload)]) + bytes(payload)
+    crc = crc16(body)
+    return bytes([D['LINK_SYNC_1'], D['LINK_SYNC_2']]) + body + bytes([crc & 0xFF, crc >> 8])
+
+
+class FrameReader:
+    """Byte by byte parser, the same state machine as PandoLink::update()."""
+
+    def __init__(self):
+        self.state, self.buffer = 0, b''
+
+    def feed(self, data):
+        """Returns (command, payload, crc_ok) for every complete frame."""
+        frames = []
+        for b in data:
+            if self.state == 0:
+                self.state = 1 if b == D['LINK_SYNC_1'] else 0
+            elif self.state == 1:
+                self.state = 2 if b == D['LINK_SYNC_2'] else 0
+                self.buffer = b''
+            else:
+                self.buffer += bytes([b])
+                if len(self.buffer) >= 2 and len(self.buffer) == self.buffer[1] + 4:
+                    body, crc = self.buffer[:-2], self.buffer[-2] | (self.buffer[-1] << 8)
+                    frames.append((body[0], body[2:], crc16(body) == crc))
+                    self.state = 0
+        return frames
+
+
+#--------------------------------------------------------------
+#-- Serial port
+#--------------------------------------------------------------
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    attributes = termios.tcgetattr(fd)
+    speed = getattr(termios, 'B%d' % baud)
+    attributes[4] = attributes[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attributes)
+    return fd
+
+
+def read_reply(fd, reader, timeout):
+    end = time.time() + timeout
+    while time.time() < end:
+        ready, _, _ = select.select([fd], [], [], max(0, end - time.time()))
+        if not ready:
+            break
+        for command, payload, ok in reader.feed(os.read(fd, 256)):
+            if ok and command == D['LINK_ACK']:
+                return payload
+    raise LinkError('no answer from Pando')
+
+
+def transact(fd, command, payload=b'', retries=3, timeout=1.0):
+    """Send a frame and wait for its ACK. Resends when the frame got lost."""
+    reader = FrameReader()
+    for attempt in range(retries):
+        os.write(fd, frame(command, payload))
+        try:
+            answer = read_reply(fd, reader, timeout)
+        except LinkError:
+            continue
+        if answer[0] != command:
+            continue
+        if answer[1] == D['LINK_BAD_CRC'] and attempt < retries - 1:
+            continue
+        return answer[1], answer[2:]
+    raise LinkError('no answer from Pando')
+
+
+def expect_ok(result):
+    status, data = result
+    if status != D['LINK_OK']:
+        raise LinkError(STATUS.get(status, 'status %d' % status))
+    return data
+
+
+def priority(name):
+    return value(name.upper(), ('PRIORITY_', ''))
+
+
+#--------------------------------------------------------------
+#-- Fake Pando
+#--------------------------------------------------------------
+class FakePando:
+    """The firmware side of the protocol, to try the tool without a robot."""
+
+    def __init__(self):
+        self.slots = [None] * D['LINK_SLOTS']
+        self.playing = None
+        self.log = []
+
+    def run(self, command, payload):
+        if command == D['LINK_PING']:
+            return D['LINK_OK'], bytes([D['LINK_VERSION'], D['LINK_PAYLOAD_MAX'] - 1, D['LINK_SLOTS']])
+        if command == D['LINK_PLAY'] and len(payload) >= 2:
+            return self.play(payload[1:], payload[0]), b''
+        if command == D['LINK_STORE'] and len(payload) >= 2:
+            if payload[0] >= D['LINK_SLOTS']:
+                return D['LINK_BAD_SLOT'], b''
+            size = check_program(payload[1:])
+            if not size:
+                return D['LINK_BAD_PROGRAM'], b''
+            self.slots[payload[0]] = bytes(payload[1:1 + size])
+            return D['LINK_OK'], b''
+        if command == D['LINK_PLAY_SLOT'] and len(payload) == 2:
+            if payload[0] >= D['LINK_SLOTS']:
+                return D['LINK_BAD_SLOT'], b''
+            if self.slots[payload[0]] is None:
+                return D['LINK_EMPTY_SLOT'], b''
+            return self.play(self.slots[payload[0]], payload[1]), b''
+        if command == D['LINK_STOP'] and not payload:
+            self.playing = None
+            return D['LINK_OK'], b''
+        if command in (D['LINK_PLAY'], D['LINK_STORE'], D['LINK_PLAY_SLOT'], D['LINK_STOP']):
+            return D['LINK_BAD_LENGTH'], b''
+        return D['LINK_BAD_COMMAND'], b''
+
+    def play(self, code, level):
+        size = check_program(code)
+        if not size:
+            return D['LINK_BAD_PROGRAM']
+        self.playing = bytes(code[:size])
+        self.log.append(self.playing)
+        return D['LINK_OK']
+
+    def serve(self, fd, stop=None):
+        reader = FrameReader()
+        while stop is None or not stop.is_set():
+            ready, _, _ = select.select([fd], [], [], 0.1)
+            if not ready:
+                continue
+            try:
+                data = os.read(fd, 256)
+            except OSError:
+                return
+            for command, payload, ok in reader.feed(data):
+                status, extra = self.run(command, payload) if ok else (D['LINK_BAD_CRC'], b'')
+                os.write(fd, frame(D['LINK_ACK'], bytes([command, status]) + extra))
+
+
+def fake_port():
+    """A pseudo terminal served by a FakePando. Returns (path, pando, stop)."""
+    master, slave = os.openpty()
+    tty.setraw(master)
+    path = os.ttyname(slave)
+    pando, stop = FakePando(), threading.Event()
+    thread = threading.Thread(target=pando.serve, args=(master, stop), daemon=True)
+    thread.start()
+    return path, pando, stop
+
+
+def selftest():
+    path, pando, stop = fake_port()
+    fd = open_port(path, 115200)
+    nod = assemble(__doc__.split('Gesture text:')[1].split('Only the standard')[0]
+                   .split('\n\n', 1)[1])
+
+    assert expect_ok(transact(fd, D['LINK_PING']))[0] == D['LINK_VERSION']
+    expect_ok(transact(fd, D['LINK_PLAY'], bytes([priority('HIGH')]) + nod))
+    assert pando.playing == nod
+    expect_ok(transact(fd, D['LINK_STORE'], bytes([1]) + nod))
+    expect_ok(transact(fd, D['LINK_PLAY_SLOT'], bytes([1, 0])))
+    assert transact(fd, D['LINK_PLAY_SLOT'], bytes([2, 0]))[0] == D['LINK_EMPTY_SLOT']
+    assert transact(fd, D['LINK_STORE'], bytes([9]) + nod)[0] == D['LINK_BAD_SLOT']
+    assert transact(fd, D['LINK_PLAY'], bytes([0, D['OP_LOOP'], 2, D['OP_END']]))[0] == \
+        D['LINK_BAD_PROGRAM']
+
+    #-- Operands the firmware refuses: gait period and dir, bend prop, count and range
+    def gait(number, period, direction):
+        return [D['OP_GAIT'], number, 20] + word(period) + [20, direction & 0xFF]
+
+    def bend(f0, f1, prop_byte):
+        return [D['OP_BEND']] + word(f0) + word(f1) + [prop_byte, 10, 1]
+
+    def bends(f, span, step, count, prop_byte):
+        return [D['OP_BENDS']] + word(f) + word(span) + word(step) + [count, prop_byte, 10, 10]
+
+    walk = D['GAIT_WALK']
+    for code in [gait(walk, D['GAIT_T_MIN'] - 1, 1), gait(walk, D['GAIT_T_MAX'] + 1, 1),
+                 gait(walk, -1000, 1), gait(walk, 1000, 2), gait(walk, 1000, 0),
+                 bend(880, 1760, 0), bend(D['BEND_FREQ_MIN'] - 1, 1760, 20),
+                 bend(880, D['BEND_FREQ_MAX'] + 1, 20),
+                 bends(400, 100, 100, 0, 40), bends(400, 100, 100, D['BENDS_MAX'] + 1, 40),
+                 bends(400, 100, 100, 6, 0), bends(400, 30000, 100, 2, 40),
+                 bends(400, 100, -100, 6, 40)]:
+        status = transact(fd, D['LINK_PLAY'], bytes([0] + code + [D['OP_END']]))[0]
+        assert status == D['LINK_BAD_PROGRAM'], code
+    for code in [gait(D['GAIT_SWING'], 800, 0), bends(1000, 100, -100, 6, 40)]:
+        expect_ok(transact(fd, D['LINK_PLAY'], bytes([0] + code + [D['OP_END']])))
+
+    #-- A corrupted frame is refused, then the tool sends it again
+    bad = bytearray(frame(D['LINK_PING']))
+    bad[-1] ^= 0xFF
+    os.write(fd, bytes(bad))
+    assert read_reply(fd, FrameReader(), 1.0)[1] == D['LINK_BAD_CRC']
+    expect_ok(transact(fd, D['LINK_STOP']))
+    assert pando.playing is None
+
+    stop.set()
+    os.close(fd)
+    print('selftest passed (%d byte program, %d plays)' % (len(nod), len(pando.log)))
+
+
+#--------------------------------------------------------------
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--port', help='serial port of Pando')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--reset-wait', type=float, default=2.0,
+                        help='time the Arduino takes to boot when the port opens (s)')
+    commands = parser.add_subparsers(dest='command', required=True)
+    commands.add_parser('ping')
+    play = commands.add_parser('play')
+    play.add_argument('file')
+    play.add_argument('--priority', default='NORMAL')
+    store = commands.add_parser('store')
+    store.add_argument('slot', type=int)
+    store.add_argument('file')
+    store.add_argument('--play', action='store_true')
+    store.add_argument('--priority', default='NORMAL')
+    slot = commands.add_parser('play-slot')
+    slot.add_argument('slot', type=int)
+    slot.add_argument('--priority', default='NORMAL')
+    commands.add_parser('stop')
+    asm = commands.add_parser('assemble')
+    asm.add_argument('file')
+    commands.add_parser('fake')
+    commands.add_parser('selftest')
+    args = parser.parse_args()
+
+    try:
+        if args.command == 'selftest':
+            selftest()
+            return
+        if args.command == 'fake':
+            path, pando, stop = fake_port()
+            print('fake Pando on %s (Ctrl+C to quit)' % path)
+            try:
+                while True:
+                    time.sleep(1)
+            except KeyboardInterrupt:
+                return
+        if args.command == 'assemble':
+            code = assemble(open(args.file).read())
+            print('%d bytes: %s' % (len(code), ', '.join('%d' % b for b in code)))
+            return
+
+        if not args.port:
+            parser.error('--port is needed')
+        fd = open_port(args.port, args.baud)
+        if '/pts/' not in args.port:       # a real Arduino resets
+            time.sleep(args.reset_wait)
+
+        if args.command == 'ping':
+            data = expect_ok(transact(fd, D['LINK_PING']))
+            print('Pando link v%d, programs up to %d bytes, %d slots' % tuple(data[:3]))
+        elif args.command == 'play':
+            code = assemble(open(args.file).read())
+            expect_ok(transact(fd, D['LINK_PLAY'], bytes([priority(args.priority)]) + code))
+        elif args.command == 'store':
+            code = assemble(open(args.file).read())
+            expect_ok(transact(fd, D['LINK_STORE'], bytes([args.slot]) + code))
+            if args.play:
+                expect_ok(transact(fd, D['LINK_PLAY_SLOT'], bytes([args.slot, priority(args.priority)])))
+        elif args.command == 'play-slot':
+            expect_ok(transact(fd, D['LINK_PLAY_SLOT'], bytes([args.slot, priority(args.priority)])))
+        elif args.command == 'stop':
+            expect_ok(transact(fd, D['LINK_STOP']))
+        print('ok')
+    except LinkError as error:
+        sys.exit('error: %s' % error)
+
+
+if __name__ == '__main__':
+    main()